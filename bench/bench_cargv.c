@@ -0,0 +1,749 @@
+/* cargv - Microbenchmarks of readers.
+
+Generates synthetic arguments for every reader, in a few input shapes, and
+measures how fast each reader goes through them.
+
+    bench-all [-n COUNT] [-r ROUNDS] [--json FILE] [--csv FILE] [READER...]
+
+Results are printed as a table, and written as JSON or CSV to compare
+two builds.
+*/
+
+#ifndef _WIN32
+  #define _POSIX_C_SOURCE  199309L
+#endif
+
+#include "cargv/cargv.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  #include <time.h>
+#endif
+
+
+#define _BENCH_COUNT_DEFAULT   100000
+#define _BENCH_ROUNDS_DEFAULT  5
+#define _BENCH_ARG_MAX         48
+
+
+/* Time in nanoseconds, from an arbitrary point. */
+static double __now_ns(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER f, c;
+    QueryPerformanceFrequency(&f);
+    QueryPerformanceCounter(&c);
+    return (double)c.QuadPart * 1E+9 / (double)f.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1E+9 + (double)ts.tv_nsec;
+#endif
+}
+
+/* xorshift64, reproducible between builds. */
+static uint64_t __rng = 0x9E3779B97F4A7C15ULL;
+
+static unsigned __rand(unsigned n)
+{
+    __rng ^= __rng << 13;
+    __rng ^= __rng >> 7;
+    __rng ^= __rng << 17;
+    return (unsigned)(__rng % n);
+}
+
+static const char *__pick(const char *const *list, size_t count)
+{
+    return list[__rand((unsigned)count)];
+}
+
+
+/* Input shapes */
+enum bench_shape_t {
+    BENCH_VALID = 0,
+    BENCH_MALFORMED,
+    BENCH_OVERFLOW,
+    BENCH_MIXED,
+    BENCH_SHAPE_COUNT,
+};
+
+static const char *_SHAPE_NAMES[] = {
+    "valid", "malformed", "overflow", "mixed",
+};
+
+
+/* Generate an argument of a shape.
+
+[out] return: 1 if generated, 0 if the reader has no such shape.
+[out] arg: Generated argument, _BENCH_ARG_MAX bytes at least.
+*/
+typedef int f_bench_gen(char *arg, enum bench_shape_t shape);
+
+/* Read an argument.
+
+[out] return: Result of the reader.
+*/
+typedef cargv_len_t f_bench_read(struct cargv_t *cargv);
+
+
+static int gen_int(char *arg, enum bench_shape_t shape)
+{
+    static const char *malformed[] = { "12a34", "--5", "abc", "1_", "+", };
+
+    switch (shape) {
+    case BENCH_VALID:
+        sprintf(arg, "%s%u%03u", __rand(2) ? "-" : "",
+                __rand(1000000), __rand(1000));
+        return 1;
+    case BENCH_MALFORMED:
+        strcpy(arg, __pick(malformed, sizeof(malformed)/sizeof(*malformed)));
+        return 1;
+    case BENCH_OVERFLOW:
+        sprintf(arg, "%s9%09u%09u%u", __rand(2) ? "-" : "",
+                __rand(1000000000), __rand(1000000000), __rand(10));
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+static int gen_uint(char *arg, enum bench_shape_t shape)
+{
+    static const char *malformed[] = { "-1", "12a34", "abc", "1__0", };
+
+    switch (shape) {
+    case BENCH_VALID:
+        sprintf(arg, "%u%09u", __rand(1000000), __rand(1000000000));
+        return 1;
+    case BENCH_MALFORMED:
+        strcpy(arg, __pick(malformed, sizeof(malformed)/sizeof(*malformed)));
+        return 1;
+    case BENCH_OVERFLOW:
+        sprintf(arg, "2%09u%09u%u",
+                __rand(1000000000), __rand(1000000000), __rand(10));
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+static int gen_real(char *arg, enum bench_shape_t shape)
+{
+    static const char *malformed[] = { "1.2.3,4.5", "1e", "--5", "0x1p3", };
+
+    switch (shape) {
+    case BENCH_VALID:
+        switch (__rand(3)) {
+        case 0:
+            sprintf(arg, "%s%u.%u", __rand(2) ? "-" : "",
+                    __rand(1000), __rand(1000000));
+            break;
+        case 1:
+            sprintf(arg, "%u.%06ue%s%u", __rand(10), __rand(1000000),
+                    __rand(2) ? "-" : "+", __rand(300));
+            break;
+        default:
+            sprintf(arg, "0.%09u%09u", __rand(1000000000), __rand(1000000000));
+            break;
+        }
+        return 1;
+    case BENCH_MALFORMED:
+        strcpy(arg, __pick(malformed, sizeof(malformed)/sizeof(*malformed)));
+        return 1;
+    case BENCH_OVERFLOW:
+        sprintf(arg, "%u.%ue%u", 1 + __rand(9), __rand(1000), 309 + __rand(90));
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+static int gen_date(char *arg, enum bench_shape_t shape)
+{
+    static const char *malformed[] = {
+        "2019-06-03x", "20x9-01-01", "2019--1", "June", "2019-06-03T",
+    };
+
+    switch (shape) {
+    case BENCH_VALID:
+        switch (__rand(4)) {
+        case 0: sprintf(arg, "%04u-%02u-%02u", 1900 + __rand(200),
+                        1 + __rand(12), 1 + __rand(28)); break;
+        case 1: sprintf(arg, "%04u%02u%02u", 1900 + __rand(200),
+                        1 + __rand(12), 1 + __rand(28)); break;
+        case 2: sprintf(arg, "--%02u-%02u", 1 + __rand(12),
+                        1 + __rand(28)); break;
+        default: sprintf(arg, "%04u-%u", 1900 + __rand(200),
+                         1 + __rand(12)); break;
+        }
+        return 1;
+    case BENCH_MALFORMED:
+        strcpy(arg, __pick(malformed, sizeof(malformed)/sizeof(*malformed)));
+        return 1;
+    case BENCH_OVERFLOW:
+        sprintf(arg, "%04u-%02u-%02u", 1900 + __rand(200),
+                13 + __rand(80), 1 + __rand(28));
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+static int gen_timezone(char *arg, enum bench_shape_t shape)
+{
+    static const char *valid[] = { "Z", "+0900", "-05:30", "+9", "-12", };
+    static const char *malformed[] = { "+9:3:0", "09", "UTC", "+", };
+    static const char *overflow[] = { "+15:00", "-13", "+0960", };
+
+    switch (shape) {
+    case BENCH_VALID:
+        strcpy(arg, __pick(valid, sizeof(valid)/sizeof(*valid)));
+        return 1;
+    case BENCH_MALFORMED:
+        strcpy(arg, __pick(malformed, sizeof(malformed)/sizeof(*malformed)));
+        return 1;
+    case BENCH_OVERFLOW:
+        strcpy(arg, __pick(overflow, sizeof(overflow)/sizeof(*overflow)));
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+static int gen_time(char *arg, enum bench_shape_t shape)
+{
+    static const char *malformed[] = { "12:3a", "1:2:3:4", "noon", ":30", };
+
+    switch (shape) {
+    case BENCH_VALID:
+        switch (__rand(3)) {
+        case 0: sprintf(arg, "%02u:%02u:%02u", __rand(24), __rand(60),
+                        __rand(60)); break;
+        case 1: sprintf(arg, "%02u%02u", __rand(24), __rand(60)); break;
+        default: sprintf(arg, "%u:%02u", __rand(24), __rand(60)); break;
+        }
+        if (__rand(2))
+            gen_timezone(arg + strlen(arg), BENCH_VALID);
+        return 1;
+    case BENCH_MALFORMED:
+        strcpy(arg, __pick(malformed, sizeof(malformed)/sizeof(*malformed)));
+        return 1;
+    case BENCH_OVERFLOW:
+        sprintf(arg, "%02u:%02u", 25 + __rand(70), __rand(60));
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+static int gen_datetime(char *arg, enum bench_shape_t shape)
+{
+    static const char *malformed[] = {
+        "+1999-06-3T", "T08:00+9:30", "2019-06-03T08:00+9:30a", "+9:30",
+    };
+
+    switch (shape) {
+    case BENCH_VALID:
+        gen_date(arg, BENCH_VALID);
+        if (__rand(4)) {
+            strcat(arg, __rand(2) ? "T" : " ");
+            gen_time(arg + strlen(arg), BENCH_VALID);
+        }
+        return 1;
+    case BENCH_MALFORMED:
+        strcpy(arg, __pick(malformed, sizeof(malformed)/sizeof(*malformed)));
+        return 1;
+    case BENCH_OVERFLOW:
+        gen_date(arg, __rand(2) ? BENCH_OVERFLOW : BENCH_VALID);
+        strcat(arg, "T");
+        gen_time(arg + strlen(arg), BENCH_OVERFLOW);
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+/* Datetimes in one fixed format, `YYYYMMDDThhmmssZ` */
+static int gen_datetime_basic(char *arg, enum bench_shape_t shape)
+{
+    static const char *malformed[] = {
+        "20190603T080000+0930", "2019060T3080000Z", "20190603T08000Z",
+    };
+
+    switch (shape) {
+    case BENCH_VALID:
+        sprintf(arg, "%04u%02u%02uT%02u%02u%02uZ", 1 + __rand(9999),
+                1 + __rand(12), 1 + __rand(28),
+                __rand(24), __rand(60), __rand(60));
+        return 1;
+    case BENCH_MALFORMED:
+        strcpy(arg, __pick(malformed, sizeof(malformed)/sizeof(*malformed)));
+        return 1;
+    case BENCH_OVERFLOW:
+        sprintf(arg, "%04u%02u%02uT%02u%02u%02uZ", 1 + __rand(9999),
+                13 + __rand(87), 1 + __rand(28),
+                __rand(24), __rand(60), __rand(60));
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+/* Mostly YYYY-MM-DDThh:mm:ssZ, with other formats between. */
+static int gen_datetime_mixed(char *arg, enum bench_shape_t shape)
+{
+    if (shape != BENCH_VALID || __rand(8) == 0)
+        return gen_datetime(arg, shape);
+    sprintf(arg, "%04u-%02u-%02uT%02u:%02u:%02uZ", 1 + __rand(9999),
+            1 + __rand(12), 1 + __rand(28),
+            __rand(24), __rand(60), __rand(60));
+    return 1;
+}
+
+static int gen_degree(char *arg, enum bench_shape_t shape)
+{
+    static const char *malformed[] = { "37.5", "+37.5.1", "+", "+37a", };
+
+    switch (shape) {
+    case BENCH_VALID:
+        switch (__rand(3)) {
+        case 0: sprintf(arg, "%c%u.%04u", __rand(2) ? '+' : '-',
+                        __rand(180), __rand(10000)); break;
+        case 1: sprintf(arg, "%c%03u%02u.%02u", __rand(2) ? '+' : '-',
+                        __rand(180), __rand(60), __rand(100)); break;
+        default: sprintf(arg, "%c%03u%02u%02u", __rand(2) ? '+' : '-',
+                         __rand(180), __rand(60), __rand(60)); break;
+        }
+        return 1;
+    case BENCH_MALFORMED:
+        strcpy(arg, __pick(malformed, sizeof(malformed)/sizeof(*malformed)));
+        return 1;
+    case BENCH_OVERFLOW:
+        sprintf(arg, "+%u.%07u", 400 + __rand(500), __rand(10000000));
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+static int gen_geocoord(char *arg, enum bench_shape_t shape)
+{
+    static const char *malformed[] = { "+37.5", "37.5+126.9", "+37.5+a/", };
+
+    switch (shape) {
+    case BENCH_VALID:
+        sprintf(arg, "%c%02u.%04u%c%03u.%04u/",
+                __rand(2) ? '+' : '-', __rand(90), __rand(10000),
+                __rand(2) ? '+' : '-', __rand(180), __rand(10000));
+        return 1;
+    case BENCH_MALFORMED:
+        strcpy(arg, __pick(malformed, sizeof(malformed)/sizeof(*malformed)));
+        return 1;
+    case BENCH_OVERFLOW:
+        sprintf(arg, "+%u.5+%u.5/", 91 + __rand(200), __rand(180));
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+static int gen_opt(char *arg, enum bench_shape_t shape)
+{
+    static const char *valid[] = {
+        "-h", "--help", "-v", "--version", "-hv", "--output", "-o",
+    };
+    static const char *malformed[] = {
+        "--hlp", "-x", "help", "--help-me", "---", "-",
+    };
+
+    switch (shape) {
+    case BENCH_VALID:
+        strcpy(arg, __pick(valid, sizeof(valid)/sizeof(*valid)));
+        return 1;
+    case BENCH_MALFORMED:
+        strcpy(arg, __pick(malformed, sizeof(malformed)/sizeof(*malformed)));
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+/* Choices, like region codes, `C0000|C0001|...` */
+#define _BENCH_CHOICES  2000
+
+static char __choice_list[_BENCH_CHOICES * 6];
+
+static const char *__choices(void)
+{
+    char *t = __choice_list;
+    int i;
+
+    if (!__choice_list[0])
+        for (i = 0; i < _BENCH_CHOICES; ++i)
+            t += sprintf(t, "%sC%04d", i ? "|" : "", i);
+    return __choice_list;
+}
+
+static int gen_choice(char *arg, enum bench_shape_t shape)
+{
+    static const char *malformed[] = { "C", "c0001", "C00001", "", "C-1", };
+
+    switch (shape) {
+    case BENCH_VALID:
+        sprintf(arg, "C%04u", __rand(_BENCH_CHOICES));
+        return 1;
+    case BENCH_MALFORMED:
+        strcpy(arg, __pick(malformed, sizeof(malformed)/sizeof(*malformed)));
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+
+static cargv_len_t read_int(struct cargv_t *cargv)
+{
+    cargv_int_t v;
+    return cargv_int(cargv, "bench", &v, 1);
+}
+
+static cargv_len_t read_uint(struct cargv_t *cargv)
+{
+    cargv_uint_t v;
+    return cargv_uint(cargv, "bench", &v, 1);
+}
+
+static cargv_len_t read_real(struct cargv_t *cargv)
+{
+    cargv_real_t v;
+    return cargv_real(cargv, "bench", &v, 1);
+}
+
+static cargv_len_t read_date(struct cargv_t *cargv)
+{
+    struct cargv_datetime_t v;
+    return cargv_date(cargv, "bench", &v, 1);
+}
+
+static cargv_len_t read_time(struct cargv_t *cargv)
+{
+    struct cargv_datetime_t v;
+    return cargv_time(cargv, "bench", &v, 1);
+}
+
+static cargv_len_t read_timezone(struct cargv_t *cargv)
+{
+    struct cargv_timezone_t v;
+    return cargv_timezone(cargv, "bench", &v, 1);
+}
+
+static cargv_len_t read_datetime(struct cargv_t *cargv)
+{
+    struct cargv_datetime_t v;
+    return cargv_datetime(cargv, "bench", &v, 1);
+}
+
+static cargv_len_t read_datetime_format(struct cargv_t *cargv)
+{
+    struct cargv_datetime_t v;
+    return cargv_datetime_format(
+        cargv, "bench", CARGV_FORMAT_DATETIME_BASIC_Z, &v, 1);
+}
+
+static cargv_len_t read_degree(struct cargv_t *cargv)
+{
+    struct cargv_degree_t v;
+    return cargv_degree(cargv, "bench", &v, 1);
+}
+
+static cargv_len_t read_geocoord(struct cargv_t *cargv)
+{
+    struct cargv_geocoord_t v;
+    return cargv_geocoord(cargv, "bench", &v, 1);
+}
+
+static cargv_len_t read_opt(struct cargv_t *cargv)
+{
+    return cargv_opt(cargv, "-h--help-v--version-o--output");
+}
+
+static cargv_len_t read_choice(struct cargv_t *cargv)
+{
+    static struct cargv_arena_t arena;
+    static struct cargv_choiceset_t set;
+    cargv_len_t v;
+
+    if (!set.slots) {
+        cargv_arena_init(&arena, NULL, 0, 0);
+        cargv_choiceset_init(&set, __choices(), "|", &arena);
+    }
+    return cargv_choice(cargv, "bench", &set, &v, 1);
+}
+
+static cargv_len_t read_oneof(struct cargv_t *cargv)
+{
+    const char *v;
+    return cargv_oneof(cargv, "bench", __choices(), "|", &v, 1);
+}
+
+
+struct bench_reader_t {
+    const char *name;
+    f_bench_gen *gen;
+    f_bench_read *read;
+};
+
+static const struct bench_reader_t _READERS[] = {
+    { "int",        gen_int,        read_int },
+    { "uint",       gen_uint,       read_uint },
+    { "real",       gen_real,       read_real },
+    { "date",       gen_date,       read_date },
+    { "time",       gen_time,       read_time },
+    { "timezone",   gen_timezone,   read_timezone },
+    { "datetime",   gen_datetime,   read_datetime },
+    { "datetime-basic", gen_datetime_basic, read_datetime },
+    { "datetime-format", gen_datetime_basic, read_datetime_format },
+    { "datetime-mixed", gen_datetime_mixed, read_datetime },
+    { "degree",     gen_degree,     read_degree },
+    { "geocoord",   gen_geocoord,   read_geocoord },
+    { "opt",        gen_opt,        read_opt },
+    { "oneof",      gen_choice,     read_oneof },
+    { "choice",     gen_choice,     read_choice },
+};
+#define _READER_COUNT  (sizeof(_READERS)/sizeof(*_READERS))
+
+
+struct bench_result_t {
+    const char *reader;
+    const char *shape;
+    cargv_len_t args;
+    cargv_len_t bytes;
+    double ns_per_arg;
+    double args_per_sec;
+    double bytes_per_sec;
+};
+
+
+/* Generate a corpus of a shape. Mixed shape picks others at random.
+
+[out] return: Total bytes of arguments. 0 if the reader has no such shape.
+[out] args: Array of count arguments, pointing into `text`.
+[out] text: count * _BENCH_ARG_MAX bytes.
+*/
+static cargv_len_t __gen_corpus(
+    const char **args, char *text, cargv_len_t count,
+    f_bench_gen *gen, enum bench_shape_t shape)
+{
+    cargv_len_t i, bytes = 0;
+    enum bench_shape_t s;
+    char *t;
+
+    for (i = 0; i < count; ++i) {
+        t = text + i * _BENCH_ARG_MAX;
+        s = shape;
+        if (shape == BENCH_MIXED)
+            do {
+                s = (enum bench_shape_t)__rand(BENCH_MIXED);
+            } while (!gen(t, s));
+        else if (!gen(t, s))
+            return 0;
+        args[i] = t;
+        bytes += (cargv_len_t)strlen(t);
+    }
+    return bytes;
+}
+
+/* Run a reader over the corpus, one argument at a time.
+
+[out] return: Best time of rounds, in nanoseconds.
+*/
+static double __run(
+    const char **args, cargv_len_t count, int rounds, f_bench_read *read)
+{
+    struct cargv_t cargv;
+    struct cargv_error_sink_t errors;
+    double best = 0.0, t;
+    volatile cargv_len_t sink = 0;
+    int r;
+
+    /* Count errors only, not to time printing them. */
+    cargv_error_sink_ring(&errors, NULL, 0);
+
+    for (r = 0; r < rounds; ++r) {
+        cargv_init(&cargv, "bench", (int)count, args);
+        cargv_set_error_sink(&cargv, &errors);
+        t = __now_ns();
+        while (cargv_len(&cargv) > 0) {
+            sink += read(&cargv);
+            cargv_shift(&cargv, 1);
+        }
+        t = __now_ns() - t;
+        if (r == 0 || t < best)
+            best = t;
+    }
+    (void)sink;
+    return best;
+}
+
+
+static void __write_json(
+    FILE *f, const struct bench_result_t *res, size_t resc,
+    cargv_len_t count, int rounds)
+{
+    size_t i;
+
+    fprintf(f, "{\n  \"count\": %ld,\n  \"rounds\": %d,\n  \"results\": [\n",
+            (long)count, rounds);
+    for (i = 0; i < resc; ++i) {
+        fprintf(f,
+            "    {\"reader\": \"%s\", \"shape\": \"%s\", \"args\": %ld, "
+            "\"bytes\": %ld, \"ns_per_arg\": %.3f, \"args_per_sec\": %.0f, "
+            "\"bytes_per_sec\": %.0f}%s\n",
+            res[i].reader, res[i].shape, (long)res[i].args,
+            (long)res[i].bytes, res[i].ns_per_arg, res[i].args_per_sec,
+            res[i].bytes_per_sec, (i+1 < resc) ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+}
+
+static void __write_csv(
+    FILE *f, const struct bench_result_t *res, size_t resc)
+{
+    size_t i;
+
+    fprintf(f, "reader,shape,args,bytes,ns_per_arg,args_per_sec,"
+               "bytes_per_sec\n");
+    for (i = 0; i < resc; ++i) {
+        fprintf(f, "%s,%s,%ld,%ld,%.3f,%.0f,%.0f\n",
+            res[i].reader, res[i].shape, (long)res[i].args,
+            (long)res[i].bytes, res[i].ns_per_arg, res[i].args_per_sec,
+            res[i].bytes_per_sec);
+    }
+}
+
+static int __write_file(
+    const char *path, int json,
+    const struct bench_result_t *res, size_t resc,
+    cargv_len_t count, int rounds)
+{
+    FILE *f;
+
+    if (!(f = fopen(path, "w"))) {
+        fprintf(stderr, "bench: cannot write `%s`.\n", path);
+        return 1;
+    }
+    if (json)
+        __write_json(f, res, resc, count, rounds);
+    else
+        __write_csv(f, res, resc);
+    fclose(f);
+    return 0;
+}
+
+
+int main(int argc, const char **argv)
+{
+    struct cargv_t cargv;
+    cargv_int_t count = _BENCH_COUNT_DEFAULT, rounds = _BENCH_ROUNDS_DEFAULT;
+    const char *json = NULL, *csv = NULL;
+    const char *only[_READER_COUNT];
+    cargv_len_t onlyc = 0, bytes;
+    struct bench_result_t res[_READER_COUNT * BENCH_SHAPE_COUNT];
+    size_t resc = 0, i, k;
+    const char **args;
+    char *text;
+    double ns;
+    int shape, err = 0;
+
+    cargv_init(&cargv, "bench", argc, argv);
+    cargv_shift(&cargv, 1);
+    while (cargv_len(&cargv) > 0) {
+        if (cargv_opt(&cargv, "-n--count")) {
+            if (!(cargv_shift(&cargv, 1)
+                  && cargv_int(&cargv, "count", &count, 1) == 1
+                  && count > 0))
+                return 2;
+        }
+        else if (cargv_opt(&cargv, "-r--rounds")) {
+            if (!(cargv_shift(&cargv, 1)
+                  && cargv_int(&cargv, "rounds", &rounds, 1) == 1
+                  && rounds > 0))
+                return 2;
+        }
+        else if (cargv_opt(&cargv, "--json")) {
+            if (!(cargv_shift(&cargv, 1)
+                  && cargv_text(&cargv, "json", &json, 1) == 1))
+                return 2;
+        }
+        else if (cargv_opt(&cargv, "--csv")) {
+            if (!(cargv_shift(&cargv, 1)
+                  && cargv_text(&cargv, "csv", &csv, 1) == 1))
+                return 2;
+        }
+        else if (cargv_opt(&cargv, "-h--help")) {
+            printf("bench-all [-n COUNT] [-r ROUNDS] [--json FILE] "
+                   "[--csv FILE] [READER...]\n");
+            return 0;
+        }
+        else if (onlyc < (cargv_len_t)_READER_COUNT) {
+            cargv_text(&cargv, "reader", &only[onlyc++], 1);
+        }
+        cargv_shift(&cargv, 1);
+    }
+
+    args = (const char **)malloc((size_t)count * sizeof(*args));
+    text = (char *)malloc((size_t)count * _BENCH_ARG_MAX);
+    if (!args || !text) {
+        fprintf(stderr, "bench: out of memory.\n");
+        return 1;
+    }
+
+    printf("%-16s %-10s %12s %14s %14s\n",
+           "reader", "shape", "ns/arg", "args/s", "MB/s");
+    for (i = 0; i < _READER_COUNT; ++i) {
+        if (onlyc > 0) {
+            for (k = 0; k < (size_t)onlyc; ++k)
+                if (strcmp(only[k], _READERS[i].name) == 0)
+                    break;
+            if (k == (size_t)onlyc)
+                continue;
+        }
+        for (shape = 0; shape < BENCH_SHAPE_COUNT; ++shape) {
+            bytes = __gen_corpus(args, text, (cargv_len_t)count,
+                                 _READERS[i].gen, (enum bench_shape_t)shape);
+            if (bytes == 0)
+                continue;
+            ns = __run(args, (cargv_len_t)count, (int)rounds,
+                       _READERS[i].read);
+
+            res[resc].reader = _READERS[i].name;
+            res[resc].shape = _SHAPE_NAMES[shape];
+            res[resc].args = (cargv_len_t)count;
+            res[resc].bytes = bytes;
+            res[resc].ns_per_arg = ns / (double)count;
+            res[resc].args_per_sec = (double)count * 1E+9 / ns;
+            res[resc].bytes_per_sec = (double)bytes * 1E+9 / ns;
+            printf("%-16s %-10s %12.2f %14.0f %14.1f\n",
+                   res[resc].reader, res[resc].shape, res[resc].ns_per_arg,
+                   res[resc].args_per_sec, res[resc].bytes_per_sec / 1E+6);
+            fflush(stdout);
+            ++resc;
+        }
+    }
+
+    if (json)
+        err |= __write_file(json, 1, res, resc, (cargv_len_t)count,
+                            (int)rounds);
+    if (csv)
+        err |= __write_file(csv, 0, res, resc, (cargv_len_t)count,
+                            (int)rounds);
+
+    free(text);
+    free(args);
+    return err;
+}
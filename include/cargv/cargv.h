@@ -8,7 +8,19 @@
 #include <stdint.h>
 #include <time.h>
 
-#ifdef __cplusplus
+/* With CARGV_STATIC, functions are static to the translation unit which
+defines CARGV_IMPLEMENTATION with the single-header build, so that they can
+be inlined into its loops. See amalgamate.SConscript.
+*/
+#if defined(CARGV_STATIC)
+  #if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L
+    #define CARGV_EXPORT static inline
+  #elif defined(_MSC_VER)
+    #define CARGV_EXPORT static __inline
+  #else
+    #define CARGV_EXPORT static
+  #endif
+#elif defined(__cplusplus)
   #define CARGV_EXPORT extern "C"
 #else
   #define CARGV_EXPORT
@@ -23,16 +35,13 @@ struct cargv_version_t {
 };
 
 
-/* cargv object */
-struct cargv_t {
-    const char *name;
-    const char **args, **argend;
-};
-
 /* Common exit code */
 enum cargv_err_t {
     CARGV_OK    = 0,
     CARGV_VAL_OVERFLOW  = -1,   /* value is well-formed but wrong */
+    CARGV_BAD_PARAM     = -2,   /* function parameter is wrong */
+    CARGV_NO_MEMORY     = -3,   /* memory or capacity ran out */
+    CARGV_IO_ERROR      = -4,   /* file could not be read */
 };
 
 
@@ -47,6 +56,110 @@ typedef double      cargv_real_t;
 #define CARGV_UINT_MAX  UINT64_MAX
 
 
+#define CARGV_ERROR_ARG_MAX 64
+
+/* Error record. See cargv_set_error_sink().
+
+The record holds a copy of the argument, so that it outlives the buffer of
+the argument, like the window of a stream or files of cargv_init_expand().
+Arguments longer than CARGV_ERROR_ARG_MAX - 1 bytes are cut.
+*/
+struct cargv_error_t {
+    int code;               /* CARGV_VAL_OVERFLOW, ... */
+    const char *type;       /* Value type, like "integer" */
+    const char *name;       /* Value name given to the reader */
+    cargv_len_t index;      /* Argument index, 0 for the first argument of
+                               cargv_init*() */
+    cargv_len_t offset;     /* Byte offset of the argument in the buffer,
+                               -1 if not from a buffer */
+    cargv_len_t len;        /* Length of the argument */
+    char arg[CARGV_ERROR_ARG_MAX];  /* Prefix of the argument,
+                                       NUL-terminated */
+};
+
+typedef void cargv_error_fn(void *ctx, const struct cargv_error_t *err);
+
+/* Error sink. Errors go to `fn` if not null, and into `ring` otherwise.
+
+`ring` keeps the last `ringc` records; `count` counts all of them.
+*/
+struct cargv_error_sink_t {
+    cargv_error_fn *fn;
+    void *ctx;
+    struct cargv_error_t *ring;
+    cargv_len_t ringc;
+    cargv_len_t count;
+};
+
+
+/* Arena: memory of a session, released at once. See cargv_arena_init(). */
+struct cargv_arena_block_t;
+
+struct cargv_arena_t {
+    char *cur, *end;        /* Free memory of the current block */
+    struct cargv_arena_block_t *blocks;     /* Allocated blocks */
+    char *mem;              /* Caller memory, used first */
+    cargv_len_t memsize;
+    cargv_len_t blocksize;  /* Size of blocks to allocate */
+};
+
+#define CARGV_ARENA_BLOCK   65536
+
+
+/* Arguments expanded from @files. See cargv_init_expand(). */
+struct cargv_expand_map_t {
+    void *addr;
+    size_t len;
+};
+
+struct cargv_expand_t {
+    const char **args;      /* Expanded arguments, not NUL-terminated */
+    cargv_len_t *lens;      /* Lengths of args */
+    cargv_len_t argc, argcap;
+    struct cargv_expand_map_t *maps;    /* Mapped files */
+    cargv_len_t mapc, mapcap;
+    struct cargv_arena_t *arena;    /* Memory of args, lens and maps */
+    struct cargv_arena_t own;       /* Arena if none given */
+};
+
+#define CARGV_EXPAND_DEPTH  8
+
+
+/* cargv object */
+struct cargv_t {
+    const char *name;
+    const char **args, **argend;
+    cargv_len_t *lens;  /* Lengths of args, if not null.
+                           See cargv_init_lens(). */
+
+    /* Buffer source, if buf is not null. See cargv_init_buffer(). */
+    const char *buf, *bufend;
+    cargv_len_t bufc;   /* Number of arguments remained in buf */
+    char delim;
+    const char *bufbase;    /* Start of the buffer */
+
+    /* Stream source, if fd >= 0. See cargv_init_fd(). buf..bufend is in win,
+       and holds complete arguments only. */
+    int fd;
+    char *win;
+    cargv_len_t winsize;
+    const char *fillend;    /* End of data read into win */
+    cargv_len_t bufoff;     /* Stream offset of win */
+    int eof;
+
+    cargv_len_t argi;   /* Index of the first argument remained */
+    struct cargv_error_sink_t *errsink; /* Prints to stderr if null */
+    struct cargv_arena_t *arena;        /* Memory of the session, or null */
+
+    /* Format predicted for datetime arguments without a hint, learned from
+       recent arguments. See cargv_datetime_format(). */
+    int predict;        /* cargv_datetime_format_t */
+    int predict_conf;   /* Confidence of the prediction, 0..3 */
+    cargv_len_t predict_hits, predict_misses;   /* Arguments read as predicted,
+                                                   and not */
+};
+
+
 /* Datetime types */
 struct cargv_timezone_t {
     cargv_int_t hour;   /* -12..14 */
@@ -94,6 +207,58 @@ extern const struct cargv_timezone_t *CARGV_TZ_XINJIANG;
 extern const struct cargv_timezone_t *CARGV_TZ_LOCAL;
 
 
+/* Packed datetime, 12 bytes. See cargv_datetime_packed().
+
+Members not in `present` are omitted, and hold 0.
+*/
+struct cargv_datetime_packed_t {
+    int16_t year;           /* -9999..9999 */
+    uint16_t milisecond;    /* 0..999 */
+    uint8_t month;          /* 1..12 */
+    uint8_t day;            /* 1..31 */
+    uint8_t hour;           /* 0..24 */
+    uint8_t minute;         /* 0..59 */
+    uint8_t second;         /* 0..59 */
+    int8_t tz_hour;         /* -12..14 */
+    int8_t tz_minute;       /* -59..59 */
+    uint8_t present;        /* CARGV_HAS_* */
+};
+
+#define CARGV_HAS_YEAR        0x01
+#define CARGV_HAS_MONTH       0x02
+#define CARGV_HAS_DAY         0x04
+#define CARGV_HAS_HOUR        0x08
+#define CARGV_HAS_MINUTE      0x10
+#define CARGV_HAS_SECOND      0x20
+#define CARGV_HAS_MILISECOND  0x40
+#define CARGV_HAS_TZ          0x80
+
+
+/* Compiled option list. See cargv_optset_init(). */
+#define CARGV_OPTSET_LONG_MAX   64
+#define CARGV_OPTSET_SLOTS      128
+
+struct cargv_optset_t {
+    uint32_t shorts[8];     /* Bitmap of short option characters */
+    cargv_len_t shortc;     /* Number of short option characters */
+    int wildcard;           /* 1 if `-*` */
+    int longc;              /* Number of long options */
+    const char *longs[CARGV_OPTSET_LONG_MAX];     /* Long option names */
+    cargv_len_t longlens[CARGV_OPTSET_LONG_MAX];
+    unsigned char slots[CARGV_OPTSET_SLOTS];  /* Hash of longs, index+1 */
+};
+
+
+/* Compiled choice list. See cargv_choiceset_init(). */
+struct cargv_choiceset_t {
+    const char **texts;     /* Choices, not NUL-terminated */
+    cargv_len_t *lens;      /* Lengths of texts */
+    uint32_t *hashes;       /* Hashes of texts */
+    cargv_len_t count;      /* Number of choices */
+    cargv_len_t *slots;     /* Hash of choices, index+1 */
+    cargv_len_t slotmask;   /* Number of slots - 1 */
+};
+
 /* Geocoord types */
 struct cargv_degree_t {
     cargv_int_t degree, microdegree;  /* ddd.dddddd */
@@ -136,33 +301,288 @@ enum cargv_err_t cargv_init(
     const char *name,
     int argc, const char **argv);
 
+/* Initialize cargv object, with a length table of arguments.
+
+Readers take lengths of arguments from the table, instead of scanning each
+argument for NUL on every call. Negative lengths are computed on first use,
+and cached in the table. The table should live as long as the cargv object.
+
+[out] return: 0 if succeeded, <0 if error. See cargv_err_t.
+[out] cargv:  cargv object.
+[in]  name:   Display name of the program, used in error messages.
+[in]  argc, argv: Passed from main().
+[in/out] lens: Array of argc lengths of argv, or null for no table.
+               Fill with -1 to have them computed.
+*/
+CARGV_EXPORT
+enum cargv_err_t cargv_init_lens(
+    struct cargv_t *cargv,
+    const char *name,
+    int argc, const char **argv,
+    cargv_len_t *lens);
+
+/* Initialize cargv object with arguments in a memory buffer.
+
+Arguments are split by `delim`, and read in place: Nothing is copied, and
+the buffer should live as long as the cargv object. A delimiter at the end of
+the buffer ends the last argument, and does not start an empty one.
+
+    "1\n22\n333\n"   3 arguments with `\n`
+    "a\0\0b"         3 arguments with `\0`, the second is empty.
+
+Arguments are not NUL-terminated unless `delim` is `\0`. Texts from
+cargv_text() or cargv_oneof() end at the delimiter.
+
+[out] return: 0 if succeeded, <0 if error. See cargv_err_t.
+[out] cargv:  cargv object.
+[in]  name:   Display name of the program, used in error messages.
+[in]  buf, buflen: Memory buffer with arguments.
+[in]  delim:  Argument delimiter, like `\n` or `\0`.
+*/
+CARGV_EXPORT
+enum cargv_err_t cargv_init_buffer(
+    struct cargv_t *cargv,
+    const char *name,
+    const char *buf, cargv_len_t buflen, char delim);
+
+/* Initialize cargv object with arguments streamed from a file descriptor.
+
+Arguments are split by `delim` as cargv_init_buffer() does, and read into
+a window of the caller's memory, a chunk at a time. When the window runs
+out of complete arguments, cargv_shift() moves the rest to the front and
+reads more, so memory stays constant however long the stream is.
+
+Only arguments in the window are visible at a time: cargv_len() returns the
+number of them, which is 0 only at the end of the stream, and readers read
+at most that many values in a call. cargv_shift() removes at most as many
+arguments as the window holds. Texts from cargv_text() or cargv_oneof() are
+valid until the next cargv_shift().
+
+The stream ends at the first error, after the complete arguments read
+before it. An argument longer than the window is an error.
+
+[out] return: 0 if succeeded, <0 if error. See cargv_err_t.
+              CARGV_IO_ERROR if the first read failed.
+              CARGV_NO_MEMORY if the first argument is longer than the
+              window.
+[out] cargv:  cargv object.
+[in]  name:   Display name of the program, used in error messages.
+[in]  fd:     File descriptor to read, like a pipe. Not closed by cargv.
+[in]  delim:  Argument delimiter, like `\n` or `\0`.
+[in]  win, winsize: Window memory, which should live as long as `cargv`.
+*/
+CARGV_EXPORT
+enum cargv_err_t cargv_init_fd(
+    struct cargv_t *cargv,
+    const char *name,
+    int fd, char delim,
+    char *win, cargv_len_t winsize);
+
+/* Initialize cargv object, expanding @file arguments.
+
+An argument `@path` is replaced by the arguments in the file at `path`,
+which may have @file arguments in turn, up to `depth` levels. Files are
+mapped into memory, and arguments are read in place: Nothing is copied.
+
+In a file, arguments are separated by white spaces. An argument quoted by
+`'` or `"` may have white spaces, and ends at the same quote; its text is
+taken as is, without the quotes, and never expanded. There are no escape
+characters.
+
+Expanded arguments are not NUL-terminated. Texts from cargv_text() or
+cargv_oneof() are valid as long as `exp`, and their lengths are in
+`exp->lens`.
+
+[out] return: 0 if succeeded, <0 if error. See cargv_err_t.
+              CARGV_IO_ERROR if a file could not be read.
+              CARGV_NO_MEMORY if out of memory, or nested deeper than
+              `depth`.
+              CARGV_BAD_PARAM if a quote is not closed.
+[out] cargv:  cargv object.
+[in]  name:   Display name of the program, used in error messages.
+[in]  argc, argv: Passed from main().
+[out] exp:    Expanded arguments and mapped files. Release with
+              cargv_expand_release(), even on failure.
+[in]  depth:  Max levels of nested @files, like CARGV_EXPAND_DEPTH.
+              0 not to expand.
+[in]  arena:  Arena to allocate tables from, also set to `cargv`.
+              Null for an arena of `exp` own.
+*/
+CARGV_EXPORT
+enum cargv_err_t cargv_init_expand(
+    struct cargv_t *cargv,
+    const char *name,
+    int argc, const char **argv,
+    struct cargv_expand_t *exp,
+    int depth,
+    struct cargv_arena_t *arena);
+
+/* Unmap files expanded by cargv_init_expand(). Tables are released too,
+unless they are in an arena given to cargv_init_expand(). */
+CARGV_EXPORT
+void cargv_expand_release(struct cargv_expand_t *exp);
+
+/* Initialize an arena.
+
+Allocations are bumped from caller memory first, and then from blocks
+allocated as needed. Nothing is freed until cargv_arena_release().
+An arena is not thread-safe; use one per thread.
+
+[out] arena: Arena.
+[in]  mem, memsize: Caller memory to use first, or null and 0.
+[in]  blocksize: Size of blocks to allocate, or 0 for CARGV_ARENA_BLOCK.
+*/
+CARGV_EXPORT
+void cargv_arena_init(
+    struct cargv_arena_t *arena,
+    void *mem, cargv_len_t memsize,
+    cargv_len_t blocksize);
+
+/* Allocate memory from an arena, aligned for any type.
+
+[out] return: Memory, or null if out of memory.
+[in]  arena: Arena.
+[in]  size:  Size in bytes.
+*/
+CARGV_EXPORT
+void *cargv_arena_alloc(struct cargv_arena_t *arena, cargv_len_t size);
+
+/* Release all memory allocated from an arena.
+
+The arena stays initialized, and can be used again from the caller memory.
+*/
+CARGV_EXPORT
+void cargv_arena_release(struct cargv_arena_t *arena);
+
+/* Attach an arena to a cargv object, for memory it hands back.
+
+[in/out] cargv: cargv object.
+[in]  arena:  Arena, which should live as long as `cargv`. Null to detach.
+*/
+CARGV_EXPORT
+void cargv_set_arena(
+    struct cargv_t *cargv,
+    struct cargv_arena_t *arena);
+
+/* Send errors of readers to a sink, instead of printing to stderr.
+
+[in/out] cargv: cargv object.
+[in]  sink:   Error sink, which should live as long as `cargv`.
+              Null to print to stderr.
+*/
+CARGV_EXPORT
+void cargv_set_error_sink(
+    struct cargv_t *cargv,
+    struct cargv_error_sink_t *sink);
+
+/* Initialize an error sink calling back on every error.
+
+[out] sink: Error sink.
+[in]  fn, ctx: Called with `ctx` and the error record, which is valid only
+               during the call.
+*/
+CARGV_EXPORT
+void cargv_error_sink_callback(
+    struct cargv_error_sink_t *sink,
+    cargv_error_fn *fn, void *ctx);
+
+/* Initialize an error sink collecting errors into a ring buffer.
+
+Collecting an error costs a copy of a record; nothing is formatted until
+cargv_format_error() is called.
+
+[out] sink: Error sink.
+[in]  ring, ringc: Ring buffer of records. With 0 records, errors are only
+                   counted.
+*/
+CARGV_EXPORT
+void cargv_error_sink_ring(
+    struct cargv_error_sink_t *sink,
+    struct cargv_error_t *ring, cargv_len_t ringc);
+
+/* Initialize an error sink collecting errors into a ring buffer allocated
+from the arena of `cargv`. See cargv_error_sink_ring().
+
+[out] return: 0 if succeeded, <0 if error. See cargv_err_t.
+              CARGV_BAD_PARAM if `cargv` has no arena.
+              CARGV_NO_MEMORY if out of memory.
+[out] sink: Error sink, also set to `cargv`.
+[in/out] cargv: cargv object with an arena. See cargv_set_arena().
+[in]  ringc: Number of records to keep.
+*/
+CARGV_EXPORT
+enum cargv_err_t cargv_error_sink_alloc(
+    struct cargv_error_sink_t *sink,
+    struct cargv_t *cargv,
+    cargv_len_t ringc);
+
+/* Get a collected error record, oldest first.
+
+[out] return: The record, or null if `i` is out of the records kept.
+[in]  sink: Error sink with a ring buffer.
+[in]  i:    0 for the oldest record kept.
+*/
+CARGV_EXPORT
+const struct cargv_error_t *cargv_error_at(
+    const struct cargv_error_sink_t *sink,
+    cargv_len_t i);
+
+/* Format an error record into a message, as printed to stderr by default,
+with the argument cut as in the record.
+
+[out] return: Length of the message, like snprintf().
+[out] buf, bufc: Buffer for the message, always NUL-terminated if bufc > 0.
+[in]  cargv: cargv object, for the program name.
+[in]  err:   Error record.
+*/
+CARGV_EXPORT
+cargv_len_t cargv_format_error(
+    char *buf, cargv_len_t bufc,
+    const struct cargv_t *cargv,
+    const struct cargv_error_t *err);
+
 /* Get number of arguments remained.
 
 [out] return: Number of arguments.
 [in]  cargv:  cargv object.
 */
 CARGV_EXPORT
-int cargv_len(const struct cargv_t *cargv);
+cargv_len_t cargv_len(const struct cargv_t *cargv);
 
 /* Shift: remove the first N arguments from the argument list.
 
 [out] return: Number of arguments actually removed.
               0 if arguments are less than requested.
+              <0 if reading a stream failed. See cargv_init_fd(). Arguments
+              are removed only if the read was for the ones after them.
 [in]  cargv:  cargv object. Untouched when returns 0.
 [in]  argc:   Number of arguments to remove.
 */
 CARGV_EXPORT
-int cargv_shift(struct cargv_t *cargv, cargv_len_t argc);
+cargv_len_t cargv_shift(struct cargv_t *cargv, cargv_len_t argc);
+
+/* Get the first argument as it is.
+
+[out] return: Length of the argument. -1 if no arguments remained.
+[in]  cargv:  cargv object.
+[out] arg:    The argument, which is not NUL-terminated unless given so.
+              Untouched if no arguments remained.
+*/
+CARGV_EXPORT
+cargv_len_t cargv_arg(struct cargv_t *cargv, const char **arg);
 
 /* See if the first argument is found in an option list.
 
-Short options:  Options with short prefix(defaults `-`) and a character
-                [a-zA-Z0-9]. These options can be combined in one argument,
-                like `-axvf`, which is same as `-a -x -c -f`.
+Short options:  Options with short prefix(defaults `-`) and a character,
+                usually [a-zA-Z0-9]. These options can be combined in one
+                argument, like `-axvf`, which is same as `-a -x -c -f`.
+
+Long options:   Options with long prefix(defaults `--`) and a name, usually
+                words of characters [a-zA-Z0-9] combined by `-`, like
+                `--a-very-long-option`.
 
-Long options:   Options with long prefix(defaults `--`) and a name, consist of
-                words of characters [a-zA-Z0-9], optionally combined by `-`.
-                `-` should not be used twice. e.g. `--a-very-long-option`
+The list is split at `--` only. Other characters are taken as they are,
+like `-?` or `--a_b`.
 
 [out] return:   1 if an option matched.
                 0 if not matched.
@@ -177,12 +597,47 @@ Long options:   Options with long prefix(defaults `--`) and a name, consist of
     `-axvf`     `-a`, `-x`, `-c`, -`f`, or any of their combinations.
     `-h--help`  `-h`, or `--help`
     `--1st-option--2nd-option`  `--1st-option` or `--2nd-option`
+
+The option list is scanned on every call. When testing many arguments with
+the same list, compile it once with cargv_optset_init() and use
+cargv_optset() instead.
 */
 CARGV_EXPORT
 int cargv_opt(
     struct cargv_t *cargv,
     const char *optlist);
 
+/* Compile an option list.
+
+Short options are kept in a bitmap, and long options in a hash table, so
+that matching an argument does not depend on the size of the list.
+
+[out] return:   0 if succeeded, <0 if error. See cargv_err_t.
+                CARGV_NO_MEMORY if more than CARGV_OPTSET_LONG_MAX long
+                options.
+[out] optset:   Compiled option list. Refers to `optlist`, which should live
+                as long as `optset`.
+[in]  optlist:  An option list. See cargv_opt().
+*/
+CARGV_EXPORT
+enum cargv_err_t cargv_optset_init(
+    struct cargv_optset_t *optset,
+    const char *optlist);
+
+/* See if the first argument is found in a compiled option list.
+
+Same as cargv_opt(), with an option list compiled by cargv_optset_init().
+
+[out] return:   1 if an option matched.
+                0 if not matched.
+[in]  cargv:    cargv object.
+[in]  optset:   Compiled option list.
+*/
+CARGV_EXPORT
+int cargv_optset(
+    struct cargv_t *cargv,
+    const struct cargv_optset_t *optset);
+
 /* Read text value arguments.
 
 [out] return: Number of values successfully read.
@@ -192,7 +647,7 @@ int cargv_opt(
 [in]  valc:   Max number of values to read in. Values beyond are not processed.
 */
 CARGV_EXPORT
-int cargv_text(
+cargv_len_t cargv_text(
     struct cargv_t *cargv,
     const char *name,
     const char **vals, cargv_len_t valc);
@@ -209,13 +664,53 @@ int cargv_text(
 [in]  valc:   Max number of values to read in. Values beyond are not processed.
 */
 CARGV_EXPORT
-int cargv_oneof(
+cargv_len_t cargv_oneof(
     struct cargv_t *cargv,
     const char *name,
     const char *list, const char *sep,
     const char **vals, cargv_len_t valc);
 
 
+/* Compile a text list for cargv_choice().
+
+Choices are split as cargv_oneof() does, and hashed into tables allocated
+from `arena`, so reading a choice costs the same however long the list is.
+
+[out] return:   0 if succeeded, <0 if error. See cargv_err_t.
+                CARGV_BAD_PARAM if `sep` is empty.
+                CARGV_NO_MEMORY if out of memory.
+[out] set:      Compiled list. Refers to `list`, which should live as long
+                as `set`.
+[in]  list:     Text list separated by `sep`.
+[in]  sep:      Text separator.
+[in]  arena:    Arena to allocate tables from. See cargv_arena_init().
+*/
+CARGV_EXPORT
+enum cargv_err_t cargv_choiceset_init(
+    struct cargv_choiceset_t *set,
+    const char *list, const char *sep,
+    struct cargv_arena_t *arena);
+
+/* Read text value arguments if in a compiled list, as indices of the list.
+
+Same as cargv_oneof(), except that values are indices of choices in the
+list, from 0. A repeated choice reads as the index of the first one. Empty
+choices are counted in indices, but never match, as in cargv_oneof().
+
+[out] return: Number of values successfully read.
+[in]  cargv:  cargv object.
+[in]  name:   Display name of the program, used in error messages.
+[in]  set:    Compiled list. See cargv_choiceset_init().
+[out] vals:   Array to read indices into.
+[in]  valc:   Max number of values to read in. Values beyond are not processed.
+*/
+CARGV_EXPORT
+cargv_len_t cargv_choice(
+    struct cargv_t *cargv,
+    const char *name,
+    const struct cargv_choiceset_t *set,
+    cargv_len_t *vals, cargv_len_t valc);
+
 /* Read signed integer value arguments.
 
   [+-]<0-9.,_>{1..}
@@ -230,7 +725,7 @@ int cargv_oneof(
 [in]  valc:   Max number of values to read in. Values beyond are not processed.
 */
 CARGV_EXPORT
-int cargv_int(
+cargv_len_t cargv_int(
     struct cargv_t *cargv,
     const char *name,
     cargv_int_t *vals, cargv_len_t valc);
@@ -250,12 +745,42 @@ int cargv_int(
 [in]  valc:   Max number of values to read in. Values beyond are not processed.
 */
 CARGV_EXPORT
-int cargv_uint(
+cargv_len_t cargv_uint(
     struct cargv_t *cargv,
     const char *name,
     cargv_uint_t *vals, cargv_len_t valc);
 
 
+/* Read real value arguments.
+
+  [+-]<0-9.,_>{1..}[<eE>[+-]<0-9>{1..}]
+
+- At least one digit is required.
+- `.` or `,` appearing once is the decimal point, like `0.5` or `0,5`.
+  Followed by exactly three digits, it is a group separator, as
+  cargv_int() reads it: `1,000` and `1.000` are 1000, but `12,34` is 12.34.
+  With `_` or an exponent, it is the decimal point, like `1.250e1`.
+- `_`, or `.` or `,` appearing more than once, is a group separator,
+  like `1_000.5` or `1.000.000`.
+- With both `.` and `,`, the last one is the decimal point and the other is
+  the group separator, like `1,234.5` or `1.234,5`.
+- Group separators may not be mixed. `1,234_567` is error.
+
+Values are rounded to the nearest cargv_real_t, regardless of the locale.
+
+[out] return: Number of values successfully read.
+              CARGV_VAL_OVERFLOW if any values are too large for
+              cargv_real_t. Too small values are read as 0.
+[out] vals:   Array to read values into.
+[in]  valc:   Max number of values to read in. Values beyond are not processed.
+*/
+CARGV_EXPORT
+cargv_len_t cargv_real(
+    struct cargv_t *cargv,
+    const char *name,
+    cargv_real_t *vals, cargv_len_t valc);
+
+
 /* Read date value arguments.
 
 Modified ISO 8601:
@@ -282,7 +807,7 @@ Modified ISO 8601:
 [in]  valc:   Max number of values to read in. Values beyond are not processed.
 */
 CARGV_EXPORT
-int cargv_date(
+cargv_len_t cargv_date(
     struct cargv_t *cargv,
     const char *name,
     struct cargv_datetime_t *vals, cargv_len_t valc);
@@ -309,7 +834,7 @@ Omitted time zone represents system local time.
 [in]  valc:   Max number of values to read in. Values beyond are not processed.
 */
 CARGV_EXPORT
-int cargv_time(
+cargv_len_t cargv_time(
     struct cargv_t *cargv,
     const char *name,
     struct cargv_datetime_t *vals, cargv_len_t valc);
@@ -322,6 +847,8 @@ Modified ISO 8601:
   <+->[h]h:[m]m   time offset
   <+->hhmm
   <+->[h]h
+  Area/Location   zone of the tz database, at the current time
+  [Area/Location]
 
 [out] return: Number of values successfully read.
               CARGV_VAL_OVERFLOW if any read value are not valid.
@@ -329,7 +856,7 @@ Modified ISO 8601:
 [in]  valc:   Max number of values to read in. Values beyond are not processed.
 */
 CARGV_EXPORT
-int cargv_timezone(
+cargv_len_t cargv_timezone(
     struct cargv_t *cargv,
     const char *name,
     struct cargv_timezone_t *vals, cargv_len_t valc);
@@ -343,6 +870,11 @@ Modified ISO 8601:
   <date>
   <time>[tz]
 
+cargv_time() and cargv_datetime() take a zone of the tz database as a
+suffix, like `2019-06-03T08:00[America/Los_Angeles]`. An omitted time zone
+is the offset of the zone at the datetime, or at the current time without
+a date. See cargv_zone_local_offset().
+
 [out] return: Number of values successfully read.
               CARGV_VAL_OVERFLOW if any read value are not valid dates.
 [out] vals:   Array to read values into.
@@ -350,16 +882,76 @@ Modified ISO 8601:
 [in]  valc:   Max number of values to read in. Values beyond are not processed.
 */
 CARGV_EXPORT
-int cargv_datetime(
+cargv_len_t cargv_datetime(
     struct cargv_t *cargv,
     const char *name,
     struct cargv_datetime_t *vals, cargv_len_t valc);
 
+/* Formats of datetime arguments, for readers with a format hint. */
+enum cargv_datetime_format_t {
+    CARGV_FORMAT_ANY = 0,
+    CARGV_FORMAT_DATE_BASIC,            /* YYYYMMDD */
+    CARGV_FORMAT_DATE_EXTENDED,         /* YYYY-MM-DD */
+    CARGV_FORMAT_TIME_BASIC,            /* hhmmss */
+    CARGV_FORMAT_TIME_EXTENDED,         /* hh:mm:ss */
+    CARGV_FORMAT_DATETIME_BASIC,        /* YYYYMMDDThhmmss */
+    CARGV_FORMAT_DATETIME_BASIC_Z,      /* YYYYMMDDThhmmssZ */
+    CARGV_FORMAT_DATETIME_EXTENDED,     /* YYYY-MM-DDThh:mm:ss */
+    CARGV_FORMAT_DATETIME_EXTENDED_Z,   /* YYYY-MM-DDThh:mm:ssZ */
+    CARGV_FORMAT_COUNT,
+};
+
+/* Read date, time, and datetime value arguments, expecting a format.
+
+Same as cargv_date(), cargv_time() and cargv_datetime(). An argument in
+`format`, which is fixed-width, is read by fields at known offsets, without
+trying other formats. `T` may be a space, as usual. Other arguments are
+read as the readers without a hint do, so values and errors are the same.
+
+Without a hint, CARGV_FORMAT_ANY, the readers predict a format from the
+arguments read before, with the same cargv object, and try it first. A
+stream of arguments in one format is mostly read as if it was hinted.
+cargv->predict_hits and cargv->predict_misses count the arguments read by
+the prediction, and not.
+
+[in]  format: Expected format. A format the reader does not read, like a
+              date format for cargv_time_format(), is the same as
+              CARGV_FORMAT_ANY.
+*/
+CARGV_EXPORT
+cargv_len_t cargv_date_format(
+    struct cargv_t *cargv,
+    const char *name,
+    enum cargv_datetime_format_t format,
+    struct cargv_datetime_t *vals, cargv_len_t valc);
+
+CARGV_EXPORT
+cargv_len_t cargv_time_format(
+    struct cargv_t *cargv,
+    const char *name,
+    enum cargv_datetime_format_t format,
+    struct cargv_datetime_t *vals, cargv_len_t valc);
+
+CARGV_EXPORT
+cargv_len_t cargv_datetime_format(
+    struct cargv_t *cargv,
+    const char *name,
+    enum cargv_datetime_format_t format,
+    struct cargv_datetime_t *vals, cargv_len_t valc);
+
 /* Convert a local datetime to another local datetime with a time zone.
 
-Resulting `hour` may be in range [0..24], and date might be modified.
+The date, if any, rolls over days, months and years. A date without the
+year is taken in a leap year, and keeps the year omitted. Omitted `hour`
+and `minute` are 0.
+
+An omitted time zone of `src`, or CARGV_TZ_LOCAL as `tz`, is the local
+zone, at the datetime, or at the current time without the year. See
+cargv_zone_local().
 
 [out] return: 0 if succeeded, <0 if error. See cargv_err_t.
+              CARGV_VAL_OVERFLOW if a member or the year converted is out
+              of range.
 [out] dst:    Converted local time.
 [in]  src:    Local time to convert.
 [in]  tz:     Time zone to convert with.
@@ -370,6 +962,209 @@ enum cargv_err_t cargv_local_datetime(
     const struct cargv_datetime_t *src,
     const struct cargv_timezone_t *tz);
 
+/* Convert local datetimes to a time zone, in bulk.
+
+Each value is converted from its own time zone, as cargv_local_datetime().
+Values between fixed time zones are converted by blocks, with vector
+instructions if the CPU has them.
+
+[out] return: Number of values converted, counted until the first value
+              failed. valc if all succeeded.
+[out] dst:    Array of valc datetimes. May be `src`.
+[in]  src, valc: Local times to convert.
+[in]  tz:     Time zone to convert to. UTC if null, or CARGV_TZ_LOCAL.
+*/
+CARGV_EXPORT
+cargv_len_t cargv_local_datetimes(
+    struct cargv_datetime_t *dst,
+    const struct cargv_datetime_t *src, cargv_len_t valc,
+    const struct cargv_timezone_t *tz);
+
+
+/* Unit of epoch time values, counted from 1970-01-01T00:00Z. */
+enum cargv_epoch_unit_t {
+    CARGV_EPOCH_SECOND = 0,
+    CARGV_EPOCH_MILISECOND,
+    CARGV_EPOCH_MICROSECOND,
+    CARGV_EPOCH_NANOSECOND,
+};
+
+/* Convert a datetime to epoch time.
+
+Omitted month and day are taken as 1, and omitted time as 00:00:00.
+Omitted time zone is the local zone, see cargv_zone_local(). Year must
+not be omitted. Values finer than `unit` are truncated toward the past.
+
+[out] return: 0 if succeeded, <0 if error. See cargv_err_t.
+              CARGV_BAD_PARAM if the year is omitted.
+              CARGV_VAL_OVERFLOW if a member is out of its range, or the
+              result does not fit in cargv_int_t.
+[out] epoch:  Epoch time in `unit`.
+[in]  src:    Datetime to convert.
+[in]  unit:   Unit of `epoch`.
+*/
+CARGV_EXPORT
+enum cargv_err_t cargv_datetime_to_epoch(
+    cargv_int_t *epoch,
+    const struct cargv_datetime_t *src,
+    enum cargv_epoch_unit_t unit);
+
+/* Convert datetimes to epoch times, in bulk.
+
+Same as cargv_datetime_to_epoch() for each value, in a loop without
+branches per value. Values in the local zone take a lookup each, mostly
+skipped for values near the value before.
+
+[out] return: Number of values converted, counted until the first value
+              failed. valc if all succeeded.
+[out] epochs: Array of valc epoch times in `unit`. Values at and after the
+              first failure are unspecified.
+[in]  vals, valc: Datetimes to convert.
+[in]  unit:   Unit of `epochs`.
+*/
+CARGV_EXPORT
+cargv_len_t cargv_datetimes_to_epochs(
+    cargv_int_t *epochs,
+    const struct cargv_datetime_t *vals, cargv_len_t valc,
+    enum cargv_epoch_unit_t unit);
+
+/* Convert an epoch time to a datetime in a time zone.
+
+[out] return: 0 if succeeded, <0 if error. See cargv_err_t.
+              CARGV_VAL_OVERFLOW if the year is out of range.
+[out] dst:    Datetime with all members, in time zone `tz`.
+[in]  epoch:  Epoch time in `unit`.
+[in]  unit:   Unit of `epoch`.
+[in]  tz:     Time zone of `dst`. UTC if null. CARGV_TZ_LOCAL for the
+              local zone, with its offset at `epoch` in `dst`.
+*/
+CARGV_EXPORT
+enum cargv_err_t cargv_epoch_to_datetime(
+    struct cargv_datetime_t *dst,
+    cargv_int_t epoch,
+    enum cargv_epoch_unit_t unit,
+    const struct cargv_timezone_t *tz);
+
+/* Convert epoch times to datetimes, in bulk.
+
+[out] return: Number of values converted, counted until the first value
+              failed. valc if all succeeded.
+[out] dst:    Array of valc datetimes.
+[in]  epochs, valc: Epoch times to convert.
+[in]  unit:   Unit of `epochs`.
+[in]  tz:     Time zone of `dst`. UTC if null, or CARGV_TZ_LOCAL.
+*/
+CARGV_EXPORT
+cargv_len_t cargv_epochs_to_datetimes(
+    struct cargv_datetime_t *dst,
+    const cargv_int_t *epochs, cargv_len_t valc,
+    enum cargv_epoch_unit_t unit,
+    const struct cargv_timezone_t *tz);
+
+/* A time zone of the tz database, like `Asia/Seoul`. See cargv_zone_load(). */
+struct cargv_zone_t;
+
+/* Load a time zone of the tz database.
+
+The TZif file of the zone, under $TZDIR or /usr/share/zoneinfo, is read
+once per process. Later calls with the same name return the loaded zone.
+Loaded zones are kept until the process exits. A name failed to load keeps
+failing without reading files again, for the last few such names. Thread
+safe.
+
+[out] return: 0 if succeeded, <0 if error. See cargv_err_t.
+              CARGV_BAD_PARAM if `name` is not a zone name.
+              CARGV_IO_ERROR if the zone is not found, or malformed.
+[out] zone:   Loaded zone.
+[in]  name:   Zone name, like `America/Los_Angeles`.
+*/
+CARGV_EXPORT
+enum cargv_err_t cargv_zone_load(
+    const struct cargv_zone_t **zone,
+    const char *name);
+
+/* Get the local time zone of the system.
+
+Resolved once per process, at the first use: TZ as a zone name, a TZif
+file path, or a POSIX TZ rule like `PST8PDT,M3.2.0,M11.1.0`, or else
+/etc/localtime. UTC if none of them is found. Later changes of TZ are
+not followed. Conversions in the local zone use it, without libc time
+functions.
+
+[out] return: 0, always.
+[out] zone:   The local zone.
+*/
+CARGV_EXPORT
+enum cargv_err_t cargv_zone_local(const struct cargv_zone_t **zone);
+
+/* Get the UTC offset of a zone at an epoch time.
+
+Seconds of offsets, of local mean times before 1900s, are truncated.
+
+[out] return: 0 if succeeded, <0 if error. See cargv_err_t.
+              CARGV_VAL_OVERFLOW if the year is out of range, or the
+              offset is out of range of cargv_timezone_t.
+[out] tz:     UTC offset.
+[in]  zone:   Zone loaded by cargv_zone_load().
+[in]  epoch:  Epoch time in seconds.
+*/
+CARGV_EXPORT
+enum cargv_err_t cargv_zone_offset(
+    struct cargv_timezone_t *tz,
+    const struct cargv_zone_t *zone,
+    cargv_int_t epoch);
+
+/* Get the UTC offset of a zone at a local datetime.
+
+Local times skipped by a transition take the offset before it, and local
+times repeated take the earlier. `tz` of `local` is ignored.
+
+[out] return: 0 if succeeded, <0 if error. See cargv_err_t.
+              Same as cargv_zone_offset() and cargv_datetime_to_epoch().
+[out] tz:     UTC offset.
+[in]  zone:   Zone loaded by cargv_zone_load().
+[in]  local:  Local datetime.
+*/
+CARGV_EXPORT
+enum cargv_err_t cargv_zone_local_offset(
+    struct cargv_timezone_t *tz,
+    const struct cargv_zone_t *zone,
+    const struct cargv_datetime_t *local);
+
+
+/* Read date, time, and datetime value arguments into packed datetimes.
+
+Same as cargv_date(), cargv_time() and cargv_datetime(), but omitted
+members are marked in `present` instead of default values.
+*/
+CARGV_EXPORT
+cargv_len_t cargv_date_packed(
+    struct cargv_t *cargv,
+    const char *name,
+    struct cargv_datetime_packed_t *vals, cargv_len_t valc);
+
+CARGV_EXPORT
+cargv_len_t cargv_time_packed(
+    struct cargv_t *cargv,
+    const char *name,
+    struct cargv_datetime_packed_t *vals, cargv_len_t valc);
+
+CARGV_EXPORT
+cargv_len_t cargv_datetime_packed(
+    struct cargv_t *cargv,
+    const char *name,
+    struct cargv_datetime_packed_t *vals, cargv_len_t valc);
+
+/* Unpack a packed datetime.
+
+[out] dst: Datetime with omitted members in default values.
+[in]  src: Packed datetime.
+*/
+CARGV_EXPORT
+void cargv_unpack_datetime(
+    struct cargv_datetime_t *dst,
+    const struct cargv_datetime_packed_t *src);
+
 
 /* Read degree value arguments.
 
@@ -386,7 +1181,7 @@ Modified ISO 6709:
 [in]  valc:   Max number of values to read in. Values beyond are not processed.
 */
 CARGV_EXPORT
-int cargv_degree(
+cargv_len_t cargv_degree(
     struct cargv_t *cargv,
     const char *name,
     struct cargv_degree_t *vals, cargv_len_t valc);
@@ -404,7 +1199,7 @@ Modified ISO 6709:
 [in]  valc:   Max number of values to read in. Values beyond are not processed.
 */
 CARGV_EXPORT
-int cargv_geocoord(
+cargv_len_t cargv_geocoord(
     struct cargv_t *cargv,
     const char *name,
     struct cargv_geocoord_t *vals, cargv_len_t valc);
@@ -414,5 +1209,160 @@ int cargv_geocoord(
 CARGV_EXPORT
 cargv_real_t cargv_get_degree(const struct cargv_degree_t *val);
 
+/* Convert to integer nanodegrees, rounded to nearest */
+CARGV_EXPORT
+cargv_int_t cargv_get_nanodegree(const struct cargv_degree_t *val);
+
+
+/* Read degree value arguments into a column.
+
+Same as cargv_degree(), but values are written converted, as
+cargv_get_degree() or cargv_get_nanodegree() does.
+
+[out] return: Number of values successfully read.
+              CARGV_VAL_OVERFLOW if any valus are not valid degree.
+[out] degrees, nanodegrees: Array to read values into.
+[in]  valc:   Max number of values to read in. Values beyond are not processed.
+*/
+CARGV_EXPORT
+cargv_len_t cargv_degree_real(
+    struct cargv_t *cargv,
+    const char *name,
+    cargv_real_t *degrees, cargv_len_t valc);
+
+CARGV_EXPORT
+cargv_len_t cargv_degree_nano(
+    struct cargv_t *cargv,
+    const char *name,
+    cargv_int_t *nanodegrees, cargv_len_t valc);
+
+/* Read geocoord value arguments into latitude and longitude columns.
+
+Same as cargv_geocoord(), but latitudes and longitudes are written into
+separate arrays, converted as cargv_get_degree() or cargv_get_nanodegree()
+does.
+
+[out] return: Number of values successfully read.
+              CARGV_VAL_OVERFLOW if any values are not valid geocoord.
+[out] lats, lons: Arrays to read latitudes and longitudes into.
+[in]  valc:   Max number of values to read in. Values beyond are not processed.
+*/
+CARGV_EXPORT
+cargv_len_t cargv_geocoord_real(
+    struct cargv_t *cargv,
+    const char *name,
+    cargv_real_t *lats, cargv_real_t *lons, cargv_len_t valc);
+
+CARGV_EXPORT
+cargv_len_t cargv_geocoord_nano(
+    struct cargv_t *cargv,
+    const char *name,
+    cargv_int_t *lats, cargv_int_t *lons, cargv_len_t valc);
+
+
+/* Read integer, datetime, and geocoord value arguments on threads.
+
+Same as cargv_int(), cargv_datetime() and cargv_geocoord(), but arguments
+are split into chunks and read on worker threads into `vals`. Results are
+the same as the serial readers: reading stops at the first argument not
+matched, and CARGV_VAL_OVERFLOW is reported for the first wrong value.
+
+Arguments from a buffer, see cargv_init_buffer(), are read serially.
+
+[out] return: Number of values successfully read.
+              CARGV_VAL_OVERFLOW if any values are not valid.
+[out] vals:   Array to read values into. Members beyond the returned
+              number might be written.
+[in]  valc:   Max number of values to read in. Values beyond are not processed.
+[in]  threads: Number of threads, or 0 for the number of processors.
+*/
+CARGV_EXPORT
+cargv_len_t cargv_int_parallel(
+    struct cargv_t *cargv,
+    const char *name,
+    cargv_int_t *vals, cargv_len_t valc,
+    int threads);
+
+CARGV_EXPORT
+cargv_len_t cargv_datetime_parallel(
+    struct cargv_t *cargv,
+    const char *name,
+    struct cargv_datetime_t *vals, cargv_len_t valc,
+    int threads);
+
+CARGV_EXPORT
+cargv_len_t cargv_geocoord_parallel(
+    struct cargv_t *cargv,
+    const char *name,
+    struct cargv_geocoord_t *vals, cargv_len_t valc,
+    int threads);
+
+
+/* Value types of argument specs. See cargv_dispatch(). */
+enum cargv_type_t {
+    CARGV_FLAG  = 0,    /* No value. Counts options only. */
+    CARGV_TEXT,         /* const char *, see cargv_text() */
+    CARGV_ONEOF,        /* const char *, see cargv_oneof() */
+    CARGV_INT,          /* cargv_int_t */
+    CARGV_UINT,         /* cargv_uint_t */
+    CARGV_DATE,         /* struct cargv_datetime_t */
+    CARGV_TIME,         /* struct cargv_datetime_t */
+    CARGV_TIMEZONE,     /* struct cargv_timezone_t */
+    CARGV_DATETIME,     /* struct cargv_datetime_t */
+    CARGV_DEGREE,       /* struct cargv_degree_t */
+    CARGV_GEOCOORD,     /* struct cargv_geocoord_t */
+};
+
+/* Argument spec. See cargv_dispatch(). */
+struct cargv_spec_t {
+    const char *optlist;    /* Option list, see cargv_opt().
+                               Null for positional values. */
+    enum cargv_type_t type;
+    const char *name;       /* Display name of values, used in error messages */
+    void *vals;             /* Array of `type` to read values into */
+    cargv_len_t valc;       /* Max number of values */
+    const char *list, *sep; /* Text list for CARGV_ONEOF */
+
+    cargv_len_t count;      /* [out] Number of values read, or number of
+                               times a CARGV_FLAG option is found. */
+};
+
+#define CARGV_DISPATCH_LONG_MAX 256
+
+/* Dispatch arguments to specs, in one pass.
+
+Each argument is classified once, by a table built from all option lists,
+and read by the reader of its spec.
+
+- An option with a value takes the next argument as its value. Values of
+  repeated options are appended to `vals`.
+- Short options can be combined, like `-xvf FILE`. Values are taken in
+  order of the options.
+- Arguments which are not options are positional values, and read into
+  specs with null `optlist`, in order. A spec is filled up to `valc` before
+  the next one. `-` and negative numbers like `-2` are positional values,
+  unless a digit is a short option. Any other argument starting with `-`
+  is an option.
+- `--` ends options. Arguments after it are all positional values.
+
+Dispatching stops at the first argument which no spec accepts, like an
+unknown option, a missing value, or no more room. cargv object is shifted
+up to the argument, so that the caller can see what it was. Combined short
+options are taken all or none: `count` is not changed by an argument which
+stops dispatching.
+
+[out] return: Number of arguments processed.
+              <0 if error. See cargv_err_t.
+              CARGV_VAL_OVERFLOW if any value is not valid.
+              CARGV_NO_MEMORY if more than CARGV_DISPATCH_LONG_MAX long
+              options in all specs.
+[in]  cargv:  cargv object. Shifted by arguments processed.
+[in/out] specs, specc: Argument specs. `count` of each spec is set.
+*/
+CARGV_EXPORT
+cargv_len_t cargv_dispatch(
+    struct cargv_t *cargv,
+    struct cargv_spec_t *specs, cargv_len_t specc);
+
 
 #endif /* __cargv_h__ */
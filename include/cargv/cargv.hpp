@@ -0,0 +1,194 @@
+/* cargv - C++ interface, on the C functions of cargv.h.
+
+Option lists are compiled at compile time:
+
+    if (cargv::opt<"-h--help">(cv))
+        ...
+
+The list is split by a constexpr parser as cargv_opt() does, and a
+malformed list, or one with more than 64 long options, does not compile.
+Matching an argument takes a lookup in a bitmap of short options, or a few
+compares of length and characters for long options.
+
+Requires C++20.
+*/
+
+#ifndef __cargv_hpp__
+#define __cargv_hpp__
+
+#include "cargv/cargv.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+
+namespace cargv {
+
+namespace detail {
+
+/* Max long options in a list. */
+constexpr std::size_t long_max = 64;
+
+/* An option list parsed at compile time. See cargv_opt(). */
+struct spec {
+    std::uint64_t shorts[4] = {};   /* Bitmap of short option characters */
+    std::size_t shortc = 0;         /* Number of short option characters */
+    bool wildcard = false;          /* `-*` */
+    std::size_t longc = 0;          /* Number of long options */
+    std::size_t offs[long_max] = {};   /* Long option names, without `--` */
+    std::size_t lens[long_max] = {};
+    bool valid = true;
+};
+
+constexpr bool is_sep(const char *s, std::size_t i, std::size_t n)
+{
+    return i+1 < n && s[i] == '-' && s[i+1] == '-';
+}
+
+/* Find `--` from `i`, or `n` if none. */
+constexpr std::size_t find_sep(const char *s, std::size_t i, std::size_t n)
+{
+    while (i < n && !is_sep(s, i, n))
+        ++i;
+    return i;
+}
+
+/* Parse an option list of `n` characters.
+
+Split as cargv_opt() does: short options are the characters between the
+leading `-` and the first `--`, and long options are the names between
+`--`. Empty names never match. Text before the first `--` without the
+leading `-`, which cargv_opt() ignores, is malformed.
+*/
+constexpr spec parse(const char *s, std::size_t n)
+{
+    spec sp;
+    std::size_t i, name;
+
+    if (n == 2 && s[0] == '-' && s[1] == '*') {
+        sp.wildcard = true;
+        return sp;
+    }
+
+    /* Short options: -abc */
+    i = find_sep(s, 0, n);
+    if (i > 0) {
+        if (s[0] != '-') {
+            sp.valid = false;
+            return sp;
+        }
+        for (std::size_t k = 1; k < i; ++k) {
+            unsigned char c = (unsigned char)s[k];
+            sp.shorts[c >> 6] |= std::uint64_t(1) << (c & 63);
+            ++sp.shortc;
+        }
+    }
+
+    /* Long options: --name--name */
+    while (i < n) {
+        name = i + 2;
+        i = find_sep(s, name, n);
+        if (i == name)
+            continue;   /* `--` never matches */
+        if (sp.longc == long_max) {
+            sp.valid = false;
+            return sp;
+        }
+        sp.offs[sp.longc] = name;
+        sp.lens[sp.longc] = i - name;
+        ++sp.longc;
+    }
+    return sp;
+}
+
+}  // namespace detail
+
+
+/* An option list as a template argument, checked at compile time. */
+template <std::size_t N>
+struct optlist {
+    char text[N] = {};
+    detail::spec spec;
+
+    consteval optlist(const char (&s)[N])
+    {
+        for (std::size_t i = 0; i < N; ++i)
+            text[i] = s[i];
+        spec = detail::parse(text, N-1);
+        if (!spec.valid)
+            throw "cargv: malformed option list";
+    }
+};
+
+
+namespace detail {
+
+template <optlist L, std::size_t I, std::size_t... C>
+constexpr bool equal_long(const char *a, std::index_sequence<C...>)
+{
+    return ((a[C] == L.text[L.spec.offs[I] + C]) && ...);
+}
+
+template <optlist L, std::size_t... I>
+constexpr bool match_long(
+    const char *a, cargv_len_t len, std::index_sequence<I...>)
+{
+    (void)a, (void)len;     /* unused if no long options */
+    return ((len == (cargv_len_t)L.spec.lens[I]
+             && equal_long<L, I>(
+                 a, std::make_index_sequence<L.spec.lens[I]>()))
+            || ...);
+}
+
+template <optlist L>
+constexpr bool match_short(const char *a, cargv_len_t len)
+{
+    if (!(len <= (cargv_len_t)L.spec.shortc))
+        return false;
+    for (cargv_len_t i = 0; i < len; ++i) {
+        unsigned char c = (unsigned char)a[i];
+        if (!((L.spec.shorts[c >> 6] >> (c & 63)) & 1))
+            return false;
+    }
+    return true;
+}
+
+}  // namespace detail
+
+
+/* See if the first argument is found in an option list.
+
+Same as cargv_opt(), with the option list compiled at compile time.
+
+[out] return:   1 if an option matched.
+                0 if not matched.
+[in]  cargv:    cargv object.
+*/
+template <optlist L>
+inline int opt(cargv_t &cargv)
+{
+    const char *a;
+    cargv_len_t len = cargv_arg(&cargv, &a);
+
+    if (len < 2 || a[0] != '-')
+        return 0;   /* not an option, or `-` */
+    if (a[1] == '-') {
+        if (len == 2)
+            return 0;   /* `--` */
+        return L.spec.wildcard
+            || detail::match_long<L>(
+                a+2, len-2, std::make_index_sequence<L.spec.longc>());
+    }
+    return L.spec.wildcard || detail::match_short<L>(a+1, len-1);
+}
+
+template <optlist L>
+inline int opt(cargv_t *cargv)
+{
+    return opt<L>(*cargv);
+}
+
+}  // namespace cargv
+
+#endif  // __cargv_hpp__
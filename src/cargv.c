@@ -3,12 +3,36 @@
 #include "cargv/cargv_version.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <memory.h>
 #include <string.h>
 #include <math.h>
 #include <limits.h>
+#include <float.h>
 #include <stdint.h>
 
+#include <errno.h>
+
+#ifdef _WIN32
+  #include <windows.h>
+  #include <io.h>
+  #define _READ(fd, buf, len)   _read((fd), (buf), (unsigned)(len))
+#else
+  #include <pthread.h>
+  #include <unistd.h>
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #define _READ(fd, buf, len)   read((fd), (buf), (len))
+  #define _HAVE_PTHREAD  1
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) \
+    || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define _HAVE_SSE2  1
+#endif
+
 
 cargv_version_num_t cargv_version(struct cargv_version_t *ver)
 {
@@ -48,6 +72,7 @@ typedef struct _hms_t {
 } _hms;
 typedef struct cargv_timezone_t   _tz;
 typedef struct cargv_datetime_t   _datetime;
+typedef struct cargv_datetime_packed_t  _dtpack;
 typedef struct cargv_degree_t     _degree;
 typedef struct cargv_geocoord_t   _geocoord;
 
@@ -192,114 +217,149 @@ static int __unmatch_str(
 }
 
 
-/* Character matching function type */
-typedef int f_match_char(char ch, _str pattern, _len patternlen);
-
-/* See if a character is in a charset.
-
-[out] return: 1 if match, else 0.
-[in]  ch: A character to search for in the pattern.
-[in]  pattern, patternlen: A character set to search.
-*/
-static int __match_char_set(char ch, _str pattern, _len patternlen)
+#ifdef _HAVE_SSE2
+/* Number of trailing zero bits. `x` should not be 0. */
+static int __ctz(unsigned x)
 {
-    _str p, pend;
-
-    for (p = pattern, pend = pattern + patternlen; p < pend; ++p) {
-        if (ch == *p)
-            return 1;
+#if defined(__GNUC__)
+    return __builtin_ctz(x);
+#else
+    int n = 0;
+    while (!(x & 1)) {
+        x >>= 1;
+        ++n;
     }
-    return 0;
+    return n;
+#endif
 }
 
-/* See if a character is in ranges.
+/* Number of set bits. */
+static int __popcount(unsigned x)
+{
+#if defined(__GNUC__)
+    return __builtin_popcount(x);
+#else
+    int n = 0;
+    for (; x; x &= x - 1)
+        ++n;
+    return n;
+#endif
+}
+#endif
 
-[out] return: 1 if match, else 0.
-[in]  ch: A character to search for in the pattern.
-[in]  pattern, patternlen:  Character pair list. Each character pair in the
-                            string defines a range.
+/* Find a character in a text, 16 bytes at once if possible.
 
-        "az"        lowercase alphabet.
-        "90afAF"    hexadecimal digits.
+[out] return: Points the first `ch` found. `textend` if not found.
+[in]  text, textend: Text to search.
+[in]  ch: A character to search for.
 */
-static int __match_char_range(char ch, _str pattern, _len patternlen)
+static _str __find_char(_str text, _str textend, char ch)
 {
-    _str p, pend;
-
-    for (p = pattern, pend = pattern + patternlen; p+2 <= pend; p += 2) {
-        if (ch >= p[0] && ch <= p[1])
-            return 1;
+    _str t = text;
+#ifdef _HAVE_SSE2
+    const __m128i c = _mm_set1_epi8(ch);
+    int m;
+
+    for (; textend - t >= 16; t += 16) {
+        m = _mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)t), c));
+        if (m)
+            return t + __ctz((unsigned)m);
     }
-    return 0;
+#endif
+    for (; t < textend; ++t) {
+        if (*t == ch)
+            return t;
+    }
+    return textend;
 }
 
-/* See how many characters from the start of a text match to a pattern.
+/* Count a character in a text, 16 bytes at once if possible.
 
-[out] return: Length of the match. 0 if match found less than minc.
-[out] next: Points end of matched text. Untouched if no match found.
-[in] text, textend: Text to search.
-[in] pattern, patternlen: Pattern to search for.
-[in] minc: Minimum match required. Less match returns 0.
-[in] maxc: Maximum match to count. No more match is searched.
+[out] return: Number of `ch` found.
+[in]  text, textend: Text to search.
+[in]  ch: A character to count.
 */
-static int __match_chars(
-    f_match_char *matcher,
-    _str *next,
-    _str text, _str textend,
-    _str pattern, _len patternlen,
-    _len minc, _len maxc)
+static _len __count_char(_str text, _str textend, char ch)
 {
-    _str t, tend;
+    _str t = text;
+    _len n = 0;
+#ifdef _HAVE_SSE2
+    const __m128i c = _mm_set1_epi8(ch);
 
-    tend = (textend < text + maxc) ? textend : text + maxc;
-    for (t = text; t < tend; ++t) {
-        if (!(*matcher)(*t, pattern, patternlen))
-            break;
+    for (; textend - t >= 16; t += 16) {
+        n += __popcount((unsigned)_mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)t), c)));
     }
-    if (t < text + minc)
-        return 0;
-    return (int)((*next = t) - text);
+#endif
+    for (; t < textend; ++t)
+        n += (*t == ch);
+    return n;
 }
 
-/* See how many characters from the start of a text are in a charset.
 
-[out] return: Length of the match. 0 if match found less than minc.
-[out] next: Points end of matched text. Untouched if no match found.
-[in] text, textend: Text to search.
-[in] pattern, patternlen: A character set to search for.
-[in] minc: Minimum match required. Less match returns 0.
-[in] maxc: Maximum match to count. No more match is searched.
+/* Character classes, one bit each, of a character table. */
+#define _CC_DIGIT   0x01    /* 0-9 */
+#define _CC_SIGN    0x02    /* + - */
+#define _CC_FRAC    0x04    /* Fraction separator, . , */
+#define _CC_GROUP   0x08    /* Group separator, . , _ */
+#define _CC_T       0x10    /* Date and time separator, T or space */
+#define _CC_SLASH   0x20    /* / */
+#define _CC_SPACE   0x40    /* White space */
+
+#define _CC_SEP     (_CC_FRAC|_CC_GROUP)
+
+static const unsigned char __char_class[256] = {
+    /* 0x00 */ 0, 0, 0, 0, 0, 0, 0, 0, 0,
+               _CC_SPACE, _CC_SPACE, _CC_SPACE, _CC_SPACE, _CC_SPACE, 0, 0,
+    /* 0x10 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x20 */ _CC_SPACE|_CC_T, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+               _CC_SIGN, _CC_SEP, _CC_SIGN, _CC_SEP, _CC_SLASH,
+    /* 0x30 */ _CC_DIGIT, _CC_DIGIT, _CC_DIGIT, _CC_DIGIT, _CC_DIGIT,
+               _CC_DIGIT, _CC_DIGIT, _CC_DIGIT, _CC_DIGIT, _CC_DIGIT,
+               0, 0, 0, 0, 0, 0,
+    /* 0x40 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x50 */ 0, 0, 0, 0, _CC_T, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, _CC_GROUP,
+    /* 0x60 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x70 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x80..0xFF are 0 */
+};
+
+/* See if a character is in classes.
+
+[out] return: Non-zero if match, else 0.
+[in]  ch: A character.
+[in]  cls: Character classes, like `_CC_DIGIT|_CC_SIGN`.
 */
-static int __match_chars_set(
-    _str *next,
-    _str text, _str textend,
-    _str pattern, _len patternlen,
-    _len minc, _len maxc)
+static unsigned __char_is(char ch, unsigned cls)
 {
-    return __match_chars(&__match_char_set,
-        next, text, textend, pattern, patternlen, minc, maxc);
+    return __char_class[(unsigned char)ch] & cls;
 }
 
-/* See how many characters from the start of a text are in ranges.
+/* See how many characters from the start of a text are in classes.
 
 [out] return: Length of the match. 0 if match found less than minc.
 [out] next: Points end of matched text. Untouched if no match found.
 [in] text, textend: Text to search.
-[in] pattern, patternlen: Character pair list. See __match_char_range().
+[in] cls: Character classes to search for.
 [in] minc: Minimum match required. Less match returns 0.
 [in] maxc: Maximum match to count. No more match is searched.
 */
-/*
-static int __match_chars_range(
+static int __match_chars(
     _str *next,
     _str text, _str textend,
-    _str pattern, _len patternlen,
-    int minc, int maxc)
+    unsigned cls,
+    _len minc, _len maxc)
 {
-    return __match_chars(&__match_char_range,
-        next, text, textend, pattern, patternlen, minc, maxc);
+    _str t, tend;
+
+    tend = (textend - text < maxc) ? textend : text + maxc;
+    for (t = text; t < tend && __char_is(*t, cls); ++t) {
+    }
+    if (t < text + minc)
+        return 0;
+    return (int)((*next = t) - text);
 }
-*/
 
 /* Read a number sign.
 
@@ -310,15 +370,14 @@ static int __match_chars_range(
 */
 static int __read_sign(_sint *val, _str *next, _str text, _str textend)
 {
-    _str t;
-    if (__match_chars_set(&t, (t = text), textend, "-", 1, 0, 1) > 0)
-        *val = -1;
-    else {
-        __match_chars_set(&t, (t = text), textend, "+", 1, 0, 1);
-        *val = 1;
+    if (text < textend && __char_is(*text, _CC_SIGN)) {
+        *val = (*text == '-') ? -1 : 1;
+        *next = text + 1;
+        return 1;
     }
-    *next = t;
-    return (int)(*next - text);
+    *val = 1;
+    *next = text;
+    return 0;
 }
 
 /* Read a decimal digit.
@@ -330,7 +389,7 @@ static int __read_sign(_sint *val, _str *next, _str text, _str textend)
 */
 static int __read_digit_dec(_uint *val, _str *next, _str text, _str textend)
 {
-    if (text < textend && __match_char_range(*text, "09", 2) > 0) {
+    if (text < textend && __char_is(*text, _CC_DIGIT)) {
         *val = (_uint)(*text++ - '0');
         *next = text;
         return 1;
@@ -339,11 +398,260 @@ static int __read_digit_dec(_uint *val, _str *next, _str text, _str textend)
         return 0;
 }
 
-/* Read a decimal integer, without any sign or separator.
+/* Decimal digit run kernels.
 
-  <0-9>{..}
+A kernel finds a run of decimal digits at once, and converts it at once, so
+that overflow is checked once per run rather than once per digit. Kernels
+are picked at run time by CPU features. See __dec_kernel().
+
+scan: Find the end of a run of digits.
+      [out] return: End of the run.
+      [in]  text, textend: Text to scan.
+      [in/out] sep: Group separator, one of `.,_`. The first one found in the
+                    run is set, if it was 0. Separators are not allowed in the
+                    run if null.
+      [out] digits: Number of digits in the run.
+
+conv: Convert digits to a number. Digits should not overflow, at most
+      _DEC_SAFE_DIGITS.
 */
-static int __read_dec(_uint *val, _str *next, _str text, _str textend)
+typedef _str f_scan_dec(_str text, _str textend, char *sep, _len *digits);
+typedef _uint f_conv_dec(_str text, _len digits);
+
+struct _dec_kernel_t {
+    f_scan_dec *scan;
+    f_conv_dec *conv;
+};
+
+/* Any run of digits up to this never overflows _uint. */
+#define _DEC_SAFE_DIGITS  19
+
+static _str __scan_dec_scalar(_str text, _str textend, char *sep, _len *digits)
+{
+    _str t;
+    _len n = 0;
+    char s = sep ? *sep : 0;
+
+    for (t = text; t < textend; ++t) {
+        if (__char_is(*t, _CC_DIGIT))
+            ++n;
+        else if (!sep)
+            break;
+        else if (s) {
+            if (*t != s)
+                break;
+        }
+        else if (__char_is(*t, _CC_GROUP))
+            s = *t;
+        else
+            break;
+    }
+    if (sep)
+        *sep = s;
+    *digits = n;
+    return t;
+}
+
+/* Convert 8 digits at once, in a 64bit word. */
+#if (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) \
+    || defined(_M_X64) || defined(_M_IX86)
+  #define _HAVE_SWAR_DEC  1
+
+static _uint __conv_dec8_swar(_str text)
+{
+    uint64_t x;
+
+    memcpy(&x, text, sizeof(x));
+    x -= UINT64_C(0x3030303030303030);
+    x = x * 10 + (x >> 8);
+    x = ((x & UINT64_C(0x000000FF000000FF)) * (100 + (UINT64_C(1000000) << 32))
+         + ((x >> 16) & UINT64_C(0x000000FF000000FF))
+           * (1 + (UINT64_C(10000) << 32))) >> 32;
+    return (_uint)x;
+}
+#endif
+
+static _uint __conv_dec_scalar(_str text, _len digits)
+{
+    _uint u = 0;
+
+#ifdef _HAVE_SWAR_DEC
+    for (; digits >= 8; digits -= 8, text += 8)
+        u = u * 100000000 + __conv_dec8_swar(text);
+#endif
+    for (; digits > 0; --digits)
+        u = u * 10 + (_uint)(*text++ - '0');
+    return u;
+}
+
+#ifndef _HAVE_SSE2
+static const struct _dec_kernel_t __dec_kernel_scalar = {
+    &__scan_dec_scalar, &__conv_dec_scalar,
+};
+#endif
+
+#ifdef _HAVE_SSE2
+static _str __scan_dec_sse2(_str text, _str textend, char *sep, _len *digits)
+{
+    const __m128i zero = _mm_set1_epi8('0'), nine = _mm_set1_epi8(9);
+    __m128i c, x;
+    unsigned dm, sm, am, rm;
+    _str t = text;
+    _len n = 0, m;
+    char s = sep ? *sep : 0;
+
+    for (; textend - t >= 16; t += 16) {
+        c = _mm_loadu_si128((const __m128i *)t);
+        x = _mm_sub_epi8(c, zero);
+        dm = (unsigned)_mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_min_epu8(x, nine), x));
+        am = dm;
+        if (sep) {
+            if (!s) {
+                /* The first separator before any other character */
+                sm = (unsigned)_mm_movemask_epi8(_mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('.')),
+                                 _mm_cmpeq_epi8(c, _mm_set1_epi8(','))),
+                    _mm_cmpeq_epi8(c, _mm_set1_epi8('_'))));
+                rm = ~(dm | sm) & 0xFFFFu;
+                if (rm)
+                    sm &= (1u << __ctz(rm)) - 1;
+                if (sm)
+                    s = t[__ctz(sm)];
+            }
+            if (s)
+                am |= (unsigned)_mm_movemask_epi8(
+                    _mm_cmpeq_epi8(c, _mm_set1_epi8(s)));
+        }
+        rm = ~am & 0xFFFFu;
+        if (rm) {
+            rm = (1u << __ctz(rm)) - 1;
+            n += __popcount(dm & rm);
+            t += __popcount(rm);
+            goto done;
+        }
+        n += __popcount(dm);
+    }
+    t = __scan_dec_scalar(t, textend, sep ? &s : NULL, &m);
+    n += m;
+done:
+    if (sep)
+        *sep = s;
+    *digits = n;
+    return t;
+}
+
+static const struct _dec_kernel_t __dec_kernel_sse2 = {
+    &__scan_dec_sse2, &__conv_dec_scalar,
+};
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) \
+    && defined(_HAVE_SSE2)
+  #include <immintrin.h>
+  #define _HAVE_AVX2_DISPATCH  1
+
+__attribute__((target("avx2")))
+static _str __scan_dec_avx2(_str text, _str textend, char *sep, _len *digits)
+{
+    const __m256i zero = _mm256_set1_epi8('0'), nine = _mm256_set1_epi8(9);
+    __m256i c, x;
+    unsigned dm, sm, am, rm;
+    _str t = text;
+    _len n = 0, m;
+    char s = sep ? *sep : 0;
+
+    for (; textend - t >= 32; t += 32) {
+        c = _mm256_loadu_si256((const __m256i *)t);
+        x = _mm256_sub_epi8(c, zero);
+        dm = (unsigned)_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(_mm256_min_epu8(x, nine), x));
+        am = dm;
+        if (sep) {
+            if (!s) {
+                /* The first separator before any other character */
+                sm = (unsigned)_mm256_movemask_epi8(_mm256_or_si256(
+                    _mm256_or_si256(
+                        _mm256_cmpeq_epi8(c, _mm256_set1_epi8('.')),
+                        _mm256_cmpeq_epi8(c, _mm256_set1_epi8(','))),
+                    _mm256_cmpeq_epi8(c, _mm256_set1_epi8('_'))));
+                rm = ~(dm | sm);
+                if (rm)
+                    sm &= (1u << __ctz(rm)) - 1;
+                if (sm)
+                    s = t[__ctz(sm)];
+            }
+            if (s)
+                am |= (unsigned)_mm256_movemask_epi8(
+                    _mm256_cmpeq_epi8(c, _mm256_set1_epi8(s)));
+        }
+        rm = ~am;
+        if (rm) {
+            rm = (1u << __ctz(rm)) - 1;
+            n += __popcount(dm & rm);
+            t += __popcount(rm);
+            goto done;
+        }
+        n += __popcount(dm);
+    }
+    t = __scan_dec_sse2(t, textend, sep ? &s : NULL, &m);
+    n += m;
+done:
+    if (sep)
+        *sep = s;
+    *digits = n;
+    return t;
+}
+
+/* Convert 16 digits at once, by multiply-add of digit pairs, quads, and
+   octets. */
+__attribute__((target("avx2")))
+static _uint __conv_dec_avx2(_str text, _len digits)
+{
+    __m128i x;
+    _uint u = 0;
+
+    if (digits >= 16) {
+        x = _mm_sub_epi8(_mm_loadu_si128((const __m128i *)text),
+                         _mm_set1_epi8('0'));
+        x = _mm_maddubs_epi16(x, _mm_setr_epi8(
+            10,1, 10,1, 10,1, 10,1, 10,1, 10,1, 10,1, 10,1));
+        x = _mm_madd_epi16(x, _mm_setr_epi16(
+            100,1, 100,1, 100,1, 100,1));
+        x = _mm_packus_epi32(x, x);
+        x = _mm_madd_epi16(x, _mm_setr_epi16(
+            10000,1, 10000,1, 10000,1, 10000,1));
+        u = (_uint)(uint32_t)_mm_cvtsi128_si32(x) * 100000000
+            + (_uint)(uint32_t)_mm_extract_epi32(x, 1);
+        text += 16;
+        digits -= 16;
+    }
+    for (; digits > 0; --digits)
+        u = u * 10 + (_uint)(*text++ - '0');
+    return u;
+}
+
+static const struct _dec_kernel_t __dec_kernel_avx2 = {
+    &__scan_dec_avx2, &__conv_dec_avx2,
+};
+#endif
+
+/* Pick the best kernel for this CPU. */
+static const struct _dec_kernel_t *__dec_kernel(void)
+{
+#ifdef _HAVE_AVX2_DISPATCH
+    if (__builtin_cpu_supports("avx2"))
+        return &__dec_kernel_avx2;
+#endif
+#ifdef _HAVE_SSE2
+    return &__dec_kernel_sse2;
+#else
+    return &__dec_kernel_scalar;
+#endif
+}
+
+/* Read a decimal integer digit by digit, checking overflow on each. */
+static int __read_dec_checked(_uint *val, _str *next, _str text, _str textend)
 {
     _str t;
     _uint u, d;
@@ -370,11 +678,31 @@ static int __read_dec(_uint *val, _str *next, _str text, _str textend)
     return (int)(*next - text);
 }
 
-/* Read a decimal integer, without sign, with group separators.
+/* Read a decimal integer, without any sign or separator.
 
-  <0-9.,_>{..}
+  <0-9>{..}
 */
-static int __read_dec_sep(_uint *val, _str *next, _str text, _str textend)
+static int __read_dec(_uint *val, _str *next, _str text, _str textend)
+{
+    const struct _dec_kernel_t *k = __dec_kernel();
+    _str t;
+    _len n;
+
+    t = k->scan(text, textend, NULL, &n);
+    if (n == 0)
+        return 0;  /* no digit */
+    if (n > _DEC_SAFE_DIGITS)
+        return __read_dec_checked(val, next, text, textend);
+
+    *val = k->conv(text, n);
+    *next = t;
+    return (int)(*next - text);
+}
+
+/* Read a decimal integer with group separators digit by digit, checking
+   overflow on each. */
+static int __read_dec_sep_checked(
+    _uint *val, _str *next, _str text, _str textend)
 {
     _str t;
     _uint u, d;
@@ -395,7 +723,7 @@ static int __read_dec_sep(_uint *val, _str *next, _str text, _str textend)
         }
         else if (sep && *t == sep)
             ++t;
-        else if (!sep && __match_char_set(*t, ".,_", 3) > 0)
+        else if (!sep && __char_is(*t, _CC_GROUP))
             sep = *t++;
         else
             break;  /* end of match */
@@ -408,6 +736,37 @@ static int __read_dec_sep(_uint *val, _str *next, _str text, _str textend)
     return (int)(*next - text);
 }
 
+/* Read a decimal integer, without sign, with group separators.
+
+  <0-9.,_>{..}
+*/
+static int __read_dec_sep(_uint *val, _str *next, _str text, _str textend)
+{
+    const struct _dec_kernel_t *k = __dec_kernel();
+    _str t, p;
+    _uint u;
+    _len n;
+    char sep = 0;
+
+    t = k->scan(text, textend, &sep, &n);
+    if (n == 0)
+        return 0;  /* no digit */
+    if (n > _DEC_SAFE_DIGITS)
+        return __read_dec_sep_checked(val, next, text, textend);
+
+    if (!sep)
+        u = k->conv(text, n);
+    else {
+        for (p = text, u = 0; p < t; ++p) {
+            if (*p != sep)
+                u = u * 10 + (_uint)(*p - '0');
+        }
+    }
+    *next = t;
+    *val = u;
+    return (int)(*next - text);
+}
+
 /* Read a signed decimal integer.
 
   [+-]<0-9.,_>{..}
@@ -470,138 +829,546 @@ static int __read_uint_dec(_uint *val, _str *next, _str text, _str textend)
 }
 
 
-/* return 1 if the month is leap month, otherwise 0. */
-static _sint __leap(_sint year, _uint month)
-{
-    return month == 2 && ((!(year % 4) && (year % 100)) || !(year % 400));
-}
+/* Decimal reals.
 
-static _sint __days_of_month_this_year(_uint month)
+A real is read as a decimal `w * 10^e10`, w of 19 significant digits at
+most, and converted to the nearest double:
+
+1. Exactly, if w and 10^e10 are exact doubles. (Clinger)
+2. By w times a 128-bit approximation of 10^e10, if the product is far
+   enough from a halfway point. (Eisel-Lemire)
+3. By strtod() of the digits otherwise, with no decimal point, so that it
+   does not depend on the locale.
+*/
+#include "cargv_pow10.h"
+
+#define _REAL_DIGITS      19    /* Significant digits in w */
+#define _REAL_DIGITS_MAX  768   /* Significant digits affecting a double */
+#define _REAL_EXP_MAX     100000
+
+#if defined(__SIZEOF_INT128__)
+  __extension__ typedef unsigned __int128  _u128;
+#endif
+
+/* High and low words of a 64x64-bit product. */
+static uint64_t __mul64(uint64_t a, uint64_t b, uint64_t *lo)
 {
-    static const _sint days_of_month[] = {
-        0, 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
-    };
-    return days_of_month[month];
+#if defined(__SIZEOF_INT128__)
+    _u128 m = (_u128)a * b;
+    *lo = (uint64_t)m;
+    return (uint64_t)(m >> 64);
+#else
+    uint64_t al = a & 0xFFFFFFFFu, ah = a >> 32;
+    uint64_t bl = b & 0xFFFFFFFFu, bh = b >> 32;
+    uint64_t ll = al * bl, lh = al * bh, hl = ah * bl, hh = ah * bh;
+    uint64_t mid = (ll >> 32) + (lh & 0xFFFFFFFFu) + (hl & 0xFFFFFFFFu);
+
+    *lo = (mid << 32) | (ll & 0xFFFFFFFFu);
+    return hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+#endif
 }
-static _sint __days_of_month(_sint year, _uint month)
+
+/* Number of leading zero bits. `x` should not be 0. */
+static int __clz64(uint64_t x)
 {
-    static const _sint days_of_month[] = {
-        0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
-    };
-    return days_of_month[month] + __leap(year, month);
+#if defined(__GNUC__)
+    return __builtin_clzll(x);
+#else
+    int n = 0;
+    while (!(x & 0x8000000000000000ULL)) {
+        x <<= 1;
+        ++n;
+    }
+    return n;
+#endif
 }
 
-/* Read a modified ISO 8601 year, month, and day, no omission.
+/* Convert `w * 10^e10` to a double by Eisel-Lemire.
 
-[out] return: Number of characters succesfully read.
-              0 if none found. `next` untouched.
-              <0 if matched but wrong. `next` still progress.
-[out] val: Read value. Untouched on failure.
-[out] next: Points end of matched text. Untouched if no match found.
-[in] text, textend: Text to match.
+[out] return: 1 if converted, 0 if too close to call, or not normal.
+[out] bits: Bits of the double, without sign.
 */
-static int __read_iso8601_YMD(_ymd *val, _str *next, _str text, _str textend)
+static int __real_lemire(uint64_t *bits, uint64_t w, int e10)
 {
-    int r;
-    _str t;
-    _sint sign, Y;
-    _uint y, m, d, n;
+    const uint64_t *p;
+    uint64_t hi, lo, yhi, ylo, m, msb;
+    int64_t e2;
+    int z;
 
-    /* [+-]YYYYMMDD */
-    if (__read_sign(&sign, &t, (t = text), textend) >= 0
-        && __read_dec(&n, &t, t, textend) == 8) {
-        y = n / 10000;
-        m = (n % 10000) / 100;
-        d = n % 100;
+    if (w == 0 || e10 < _POW10_MIN || e10 > _POW10_MAX)
+        return 0;
+    p = _POW10[e10 - _POW10_MIN];
+
+    z = __clz64(w);
+    w <<= z;
+    /* floor(e10 * log2(10)) + 64 + bias */
+    e2 = ((e10 >= 0) ? (217706 * (int64_t)e10) >> 16
+                     : -((-217706 * (int64_t)e10 + 65535) >> 16))
+         + 64 + 1023 - z;
+
+    hi = __mul64(w, p[0], &lo);
+    if ((hi & 0x1FF) == 0x1FF && lo + w < w) {
+        /* Not enough with the high word. Add the low word. */
+        yhi = __mul64(w, p[1], &ylo);
+        if (lo + yhi < lo)
+            ++hi;
+        lo += yhi;
+        if ((hi & 0x1FF) == 0x1FF && lo + 1 == 0 && ylo + w < w)
+            return 0;
     }
-    /* [+-]Y[..4]<-/>[M]M<-/>[D]D */
-    else if (__read_sign(&sign, &t, (t = text), textend) >= 0
-             && (r = __read_dec(&y, &t, t, textend)) > 0 && r <= 4
-             && __match_chars_set(&t, t, textend, "-/", 2, 1, 1) == 1
-             && (r = __read_dec(&m, &t, t, textend)) > 0 && r <= 2
-             && __match_chars_set(&t, t, textend, "-/", 2, 1, 1) == 1
-             && (r = __read_dec(&d, &t, t, textend)) > 0 && r <= 2) {
+
+    msb = hi >> 63;
+    m = hi >> (msb + 9);
+    e2 -= (int64_t)(1 ^ msb);
+    if (lo == 0 && (hi & 0x1FF) == 0 && (m & 3) == 1)
+        return 0;   /* halfway */
+
+    m += m & 1;
+    m >>= 1;
+    if (m >> 53) {
+        m >>= 1;
+        ++e2;
     }
-    else
-        return 0;
+    if (e2 <= 0 || e2 >= 0x7FF)
+        return 0;   /* subnormal or infinite */
+    *bits = ((uint64_t)e2 << 52) | (m & 0x000FFFFFFFFFFFFFULL);
+    return 1;
+}
 
-    *next = t;
-    Y = sign * (_sint)y;
+static _real __real_from_bits(uint64_t bits)
+{
+    _real r;
+    memcpy(&r, &bits, sizeof(r));
+    return r;
+}
 
-    /* -9999-1-1..+9999-12-31 */
-    if (!(Y >= _Y_MIN && Y <= _Y_MAX
-          && m > 0 && m <= 12
-          && d > 0 && (_sint)d <= __days_of_month(Y, m)))
-        return CARGV_VAL_OVERFLOW;
+/* Convert all digits of a real by strtod(), for hard cases.
 
-    val->year = Y;
-    val->month = (_sint)m;
-    val->day = (_sint)d;
-    return (int)(*next - text);
+[out] return: Absolute value.
+[in]  m, mend: Mantissa, with `point` and `group` in it.
+[in]  e10: Exponent after the mantissa.
+*/
+static _real __real_slow(_str m, _str mend, char point, char group, _len e10)
+{
+    char buf[_REAL_DIGITS_MAX + 2 + 16];
+    _len n = 0, dropped = 0, frac = 0;
+    int after = 0, tail = 0;
+
+    for (; m < mend; ++m) {
+        if (*m == point)
+            after = 1;
+        else if (*m == group)
+            continue;
+        else {
+            if (after)
+                ++frac;
+            if (n == 0 && *m == '0')
+                continue;   /* leading zero */
+            if (n < _REAL_DIGITS_MAX)
+                buf[n++] = *m;
+            else {
+                ++dropped;
+                tail |= *m != '0';
+            }
+        }
+    }
+    if (n == 0)
+        return 0.0;
+    if (tail)
+        buf[n++] = '1';     /* sticky digit, to break ties */
+    e10 = e10 - frac + dropped - tail;
+    sprintf(buf + n, "e%ld", (long)e10);
+    return strtod(buf, NULL);
 }
 
-/* Read a modified ISO 8601 year and month only.
+/* Read a decimal real, without sign.
 
-[out] return: Number of characters succesfully read.
-              0 if none found. `next` untouched.
-              <0 if matched but wrong. `next` still progress.
-[out] val: Read value. Untouched on failure.
-[out] next: Points end of matched text. Untouched if no match found.
-[in] text, textend: Text to match.
+  <0-9.,_>{..}[<eE>[+-]<0-9>{1..}]
+
+A `.` or `,` appearing once is the decimal point, unless it is followed by
+exactly three digits, after one or more, without `_` or an exponent. Then it
+is a group separator as __read_dec_sep() reads it, like `1,000`. A separator
+appearing more than once, or `_`, is a group separator, as in
+__read_dec_sep().
+Group separators may not be mixed. With both `.` and `,`, the last one is
+the decimal point, and the other one is the group separator, like
+`1,234.5` or `1.234,5`.
 */
-static int __read_iso8601_YM(_ymd *val, _str *next, _str text, _str textend)
+static int __read_real(_real *val, _str *next, _str text, _str textend)
 {
-    int r;
-    _str t;
-    _sint sign, Y;
-    _uint y, m;
-
-    /* [+-]Y[..4]<-/>[M]M */
-    if (__read_sign(&sign, &t, (t = text), textend) >= 0
-        && (r = __read_dec(&y, &t, t, textend)) > 0 && r <= 4
-        && __match_chars_set(&t, t, textend, "-/", 2, 1, 1) == 1
-        && (r = __read_dec(&m, &t, t, textend)) > 0 && r <= 2) {
+    _str t, m, mend, sep, dot = NULL, comma = NULL;
+    _len ndot = 0, ncomma = 0, nunder = 0, digits = 0, nd = 0, e10 = 0;
+    _len x, ex = 0;
+    char point = 0, group = 0;
+    int after = 0, trunc = 0;
+    uint64_t w = 0, bits, bits1;
+    _sint esign;
+    unsigned d;
+
+    for (m = t = text; t < textend && __char_is(*t, _CC_DIGIT|_CC_GROUP);
+         ++t) {
+        if (__char_is(*t, _CC_DIGIT))
+            ++digits;
+        else if (*t == '.')
+            ++ndot, dot = t;
+        else if (*t == ',')
+            ++ncomma, comma = t;
+        else
+            ++nunder;
     }
-    else
+    mend = t;
+    if (digits == 0)
         return 0;
 
+    if (ndot && ncomma) {
+        point = (dot > comma) ? '.' : ',';
+        group = (dot > comma) ? ',' : '.';
+        if ((point == '.' ? ndot : ncomma) != 1 || nunder)
+            return 0;
+    }
+    else if (ndot + ncomma == 1) {
+        sep = ndot ? dot : comma;
+        if (!nunder && sep > m && mend - sep == 4
+            && !(mend < textend && (*mend == 'e' || *mend == 'E')))
+            group = *sep;   /* same as cargv_int() */
+        else {
+            point = *sep;
+            group = nunder ? '_' : 0;
+        }
+    }
+    else if (ndot + ncomma > 1) {
+        group = ndot ? '.' : ',';
+        if (nunder)
+            return 0;
+    }
+    else if (nunder)
+        group = '_';
+
+    for (t = m; t < mend; ++t) {
+        if (*t == point) {
+            after = 1;
+            continue;
+        }
+        if (*t == group)
+            continue;
+        d = (unsigned)(*t - '0');
+        if (nd == 0 && d == 0) {
+            if (after)
+                --e10;
+        }
+        else if (nd < _REAL_DIGITS) {
+            w = w * 10 + d;
+            ++nd;
+            if (after)
+                --e10;
+        }
+        else {
+            trunc |= d != 0;
+            if (!after)
+                ++e10;
+        }
+    }
+
+    /* Exponent */
+    if (t < textend && (*t == 'e' || *t == 'E')) {
+        ++t;
+        __read_sign(&esign, &t, t, textend);
+        if (!(t < textend && __char_is(*t, _CC_DIGIT)))
+            return 0;
+        for (x = 0; t < textend && __char_is(*t, _CC_DIGIT); ++t) {
+            if (x < _REAL_EXP_MAX)
+                x = x * 10 + (*t - '0');
+        }
+        ex = esign * x;
+        e10 += ex;
+    }
     *next = t;
-    Y = sign * (_sint)y;
 
-    /* -9999-01..+9999-12 */
-    if (!(Y >= _Y_MIN && Y <= _Y_MAX && m > 0 && m <= 12))
+    if (w == 0) {
+        *val = 0.0;
+        return (int)(*next - text);
+    }
+    if (e10 > _POW10_MAX)
         return CARGV_VAL_OVERFLOW;
+    if (e10 < _POW10_MIN) {
+        *val = 0.0;
+        return (int)(*next - text);
+    }
 
-    val->year = Y;
-    val->month = (_sint)m;
-    val->day = _D_DEFAULT;
+    if (!trunc && w <= ((uint64_t)1 << 53) && e10 >= -22 && e10 <= 22) {
+        static const _real pow10[] = {
+            1E+0, 1E+1, 1E+2, 1E+3, 1E+4, 1E+5, 1E+6, 1E+7, 1E+8, 1E+9,
+            1E+10, 1E+11, 1E+12, 1E+13, 1E+14, 1E+15, 1E+16, 1E+17, 1E+18,
+            1E+19, 1E+20, 1E+21, 1E+22,
+        };
+        *val = (e10 >= 0) ? (_real)w * pow10[e10] : (_real)w / pow10[-e10];
+    }
+    else if (__real_lemire(&bits, w, (int)e10)
+             && (!trunc || (__real_lemire(&bits1, w+1, (int)e10)
+                            && bits == bits1)))
+        *val = __real_from_bits(bits);
+    else
+        *val = __real_slow(m, mend, point, group, ex);
+    if (*val > DBL_MAX)
+        return CARGV_VAL_OVERFLOW;
     return (int)(*next - text);
 }
 
-/* Read a modified ISO 8601 year only.
+/* Read a signed decimal real.
 
-[out] return: Number of characters succesfully read.
-              0 if none found. `next` untouched.
-              <0 if matched but wrong. `next` still progress.
-[out] val: Read value. Untouched on failure.
-[out] next: Points end of matched text. Untouched if no match found.
-[in] text, textend: Text to match.
+  [+-]<0-9.,_>{..}[<eE>[+-]<0-9>{1..}]
 */
-static int __read_iso8601_Y(_ymd *val, _str *next, _str text, _str textend)
+static int __read_real_dec(_real *val, _str *next, _str text, _str textend)
 {
     int r;
     _str t;
+    _sint sign;
+    _real v;
+
+    __read_sign(&sign, &t, text, textend);
+    if ((r = __read_real(&v, &t, t, textend)) == 0)
+        return 0;
+
+    *next = t;
+    if (r < 0)
+        return r;
+    *val = (sign < 0) ? -v : v;
+    return (int)(*next - text);
+}
+
+/* return 1 if the month is leap month, otherwise 0. */
+static _sint __leap(_sint year, _uint month)
+{
+    return month == 2 && ((!(year % 4) && (year % 100)) || !(year % 400));
+}
+
+static _sint __days_of_month_this_year(_uint month)
+{
+    static const _sint days_of_month[] = {
+        0, 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
+    };
+    return days_of_month[month];
+}
+static _sint __days_of_month(_sint year, _uint month)
+{
+    static const _sint days_of_month[] = {
+        0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
+    };
+    return days_of_month[month] + __leap(year, month);
+}
+
+/* ISO 8601 tokens.
+
+A datetime argument is split into tokens in one pass over its characters,
+by a state machine driven by a character class table. Formats are then
+recognized on tokens, so that trying another alternative never reads the
+characters again.
+
+    `+1999-06-3T08:00+9:30`  +  1999  -  06  -  3  T  08  :  00  +  9  :  30
+*/
+typedef struct _tok_t {
+    char kind;      /* _TOK_DIGITS, _TOK_END, _TOK_OTHER, or the character */
+    int len;        /* number of digits */
+    _uint val;      /* value of digits, if len <= _DEC_SAFE_DIGITS */
+} _tok;
+
+#define _TOK_END      '\0'
+#define _TOK_DIGITS   '0'
+#define _TOK_OTHER    '?'
+
+/* Max tokens of any format: `+YYYY-MM-DDThh:mm:ss+hh:mm` */
+#define _TOK_MAX      16
+
+/* Token kind of each character. Digits are _TOK_DIGITS. */
+static const char __tok_kind[256] = {
+    /* 0x00 */ '?','?','?','?','?','?','?','?','?','?','?','?','?','?','?','?',
+    /* 0x10 */ '?','?','?','?','?','?','?','?','?','?','?','?','?','?','?','?',
+    /* 0x20 */ ' ','?','?','?','?','?','?','?','?','?','?','+','?','-','?','/',
+    /* 0x30 */ '0','0','0','0','0','0','0','0','0','0',':','?','?','?','?','?',
+    /* 0x40 */ '?','?','?','?','?','?','?','?','?','?','?','?','?','?','?','?',
+    /* 0x50 */ '?','?','?','?','T','?','?','?','?','?','Z','?','?','?','?','?',
+    /* 0x60 */ '?','?','?','?','?','?','?','?','?','?','?','?','?','?','?','?',
+    /* 0x70 */ '?','?','?','?','?','?','?','?','?','?','?','?','?','?','?','?',
+    /* 0x80 */ '?','?','?','?','?','?','?','?','?','?','?','?','?','?','?','?',
+    /* 0x90 */ '?','?','?','?','?','?','?','?','?','?','?','?','?','?','?','?',
+    /* 0xA0 */ '?','?','?','?','?','?','?','?','?','?','?','?','?','?','?','?',
+    /* 0xB0 */ '?','?','?','?','?','?','?','?','?','?','?','?','?','?','?','?',
+    /* 0xC0 */ '?','?','?','?','?','?','?','?','?','?','?','?','?','?','?','?',
+    /* 0xD0 */ '?','?','?','?','?','?','?','?','?','?','?','?','?','?','?','?',
+    /* 0xE0 */ '?','?','?','?','?','?','?','?','?','?','?','?','?','?','?','?',
+    /* 0xF0 */ '?','?','?','?','?','?','?','?','?','?','?','?','?','?','?','?',
+};
+
+/* Split a text into ISO 8601 tokens.
+
+[out] return: Number of tokens. More than _TOK_MAX if the text has more,
+              which no format matches.
+[out] tok:    Tokens, _TOK_MAX+2 at least. Ends with _TOK_END.
+[in]  text, textend: Text to split.
+*/
+static int __lex_iso8601(_tok *tok, _str text, _str textend)
+{
+    _str t;
+    int n;
+    char k;
+
+    for (t = text, n = 0; t < textend && n <= _TOK_MAX; ++n) {
+        k = __tok_kind[(unsigned char)*t++];
+        tok[n].kind = k;
+        if (k == _TOK_DIGITS) {
+            tok[n].val = (_uint)(t[-1] - '0');
+            tok[n].len = 1;
+            for (; t < textend && __tok_kind[(unsigned char)*t] == _TOK_DIGITS;
+                 ++t) {
+                if (tok[n].len++ < _DEC_SAFE_DIGITS)
+                    tok[n].val = tok[n].val * 10 + (_uint)(*t - '0');
+            }
+        }
+    }
+    if (t < textend)
+        ++n;    /* more than _TOK_MAX */
+    else
+        tok[n].kind = _TOK_END;
+    return n;
+}
+
+/* Match an optional sign token, `+` or `-`.
+
+[out] return: Index of the next token.
+[out] sign: -1 for `-`, 1 otherwise.
+*/
+static int __tok_sign(_sint *sign, const _tok *tok, int i)
+{
+    *sign = (tok[i].kind == '-') ? -1 : 1;
+    return (tok[i].kind == '-' || tok[i].kind == '+') ? i+1 : i;
+}
+
+/* Match a digits token with minc..maxc digits.
+
+[out] return: 1 if matched, else 0.
+[out] val: Value of digits. Untouched if not matched.
+*/
+static int __tok_dec(_uint *val, const _tok *tok, int i, int minc, int maxc)
+{
+    if (tok[i].kind == _TOK_DIGITS
+        && tok[i].len >= minc && tok[i].len <= maxc) {
+        *val = tok[i].val;
+        return 1;
+    }
+    return 0;
+}
+
+/* Match a token of one of two characters. */
+static int __tok_is(const _tok *tok, int i, char c1, char c2)
+{
+    return tok[i].kind == c1 || tok[i].kind == c2;
+}
+
+/* Recognize a modified ISO 8601 year, month, and day, no omission.
+
+[out] return: 1 if matched.
+              0 if none found. `next` untouched.
+              <0 if matched but wrong. `next` still progress.
+[out] val: Read value. Untouched on failure.
+[out] next: Index of the next token. Untouched if no match found.
+[in] tok, i: Tokens, and index to start with.
+*/
+static int __tok_iso8601_YMD(_ymd *val, int *next, const _tok *tok, int i)
+{
+    _sint sign, Y;
+    _uint y, m, d, n;
+
+    /* [+-]YYYYMMDD */
+    if (__tok_dec(&n, tok, (i = __tok_sign(&sign, tok, i)), 8, 8)) {
+        y = n / 10000;
+        m = (n % 10000) / 100;
+        d = n % 100;
+        i += 1;
+    }
+    /* [+-]Y[..4]<-/>[M]M<-/>[D]D */
+    else if (__tok_dec(&y, tok, i, 1, 4)
+             && __tok_is(tok, i+1, '-', '/')
+             && __tok_dec(&m, tok, i+2, 1, 2)
+             && __tok_is(tok, i+3, '-', '/')
+             && __tok_dec(&d, tok, i+4, 1, 2)) {
+        i += 5;
+    }
+    else
+        return 0;
+
+    *next = i;
+    Y = sign * (_sint)y;
+
+    /* -9999-1-1..+9999-12-31 */
+    if (!(Y >= _Y_MIN && Y <= _Y_MAX
+          && m > 0 && m <= 12
+          && d > 0 && (_sint)d <= __days_of_month(Y, m)))
+        return CARGV_VAL_OVERFLOW;
+
+    val->year = Y;
+    val->month = (_sint)m;
+    val->day = (_sint)d;
+    return 1;
+}
+
+/* Recognize a modified ISO 8601 year and month only.
+
+[out] return: 1 if matched.
+              0 if none found. `next` untouched.
+              <0 if matched but wrong. `next` still progress.
+[out] val: Read value. Untouched on failure.
+[out] next: Index of the next token. Untouched if no match found.
+[in] tok, i: Tokens, and index to start with.
+*/
+static int __tok_iso8601_YM(_ymd *val, int *next, const _tok *tok, int i)
+{
+    _sint sign, Y;
+    _uint y, m;
+
+    /* [+-]Y[..4]<-/>[M]M */
+    if (__tok_dec(&y, tok, (i = __tok_sign(&sign, tok, i)), 1, 4)
+        && __tok_is(tok, i+1, '-', '/')
+        && __tok_dec(&m, tok, i+2, 1, 2)) {
+        i += 3;
+    }
+    else
+        return 0;
+
+    *next = i;
+    Y = sign * (_sint)y;
+
+    /* -9999-01..+9999-12 */
+    if (!(Y >= _Y_MIN && Y <= _Y_MAX && m > 0 && m <= 12))
+        return CARGV_VAL_OVERFLOW;
+
+    val->year = Y;
+    val->month = (_sint)m;
+    val->day = _D_DEFAULT;
+    return 1;
+}
+
+/* Recognize a modified ISO 8601 year only.
+
+[out] return: 1 if matched.
+              0 if none found. `next` untouched.
+              <0 if matched but wrong. `next` still progress.
+[out] val: Read value. Untouched on failure.
+[out] next: Index of the next token. Untouched if no match found.
+[in] tok, i: Tokens, and index to start with.
+*/
+static int __tok_iso8601_Y(_ymd *val, int *next, const _tok *tok, int i)
+{
     _sint sign, Y;
     _uint y;
 
     /* [+-]Y[..4] */
-    if (__read_sign(&sign, &t, (t = text), textend) >= 0
-        && (r = __read_dec(&y, &t, t, textend)) > 0 && r <= 4) {
+    if (__tok_dec(&y, tok, (i = __tok_sign(&sign, tok, i)), 1, 4)) {
+        i += 1;
     }
     else
         return 0;
-        
-    *next = t;
+
+    *next = i;
     Y = sign * (_sint)y;
 
     /* -9999..+9999 */
@@ -611,40 +1378,42 @@ static int __read_iso8601_Y(_ymd *val, _str *next, _str text, _str textend)
     val->year = Y;
     val->month = _M_DEFAULT;
     val->day = _D_DEFAULT;
-    return (int)(*next - text);
+    return 1;
 }
 
-/* Read a modified ISO 8601 month and day only.
+/* Recognize a modified ISO 8601 month and day only.
 
-[out] return: Number of characters succesfully read.
+[out] return: 1 if matched.
               0 if none found. `next` untouched.
               <0 if matched but wrong. `next` still progress.
 [out] val: Read value. Untouched on failure.
-[out] next: Points end of matched text. Untouched if no match found.
-[in] text, textend: Text to match.
+[out] next: Index of the next token. Untouched if no match found.
+[in] tok, i: Tokens, and index to start with.
 */
-static int __read_iso8601_MD(_ymd *val, _str *next, _str text, _str textend)
+static int __tok_iso8601_MD(_ymd *val, int *next, const _tok *tok, int i)
 {
-    int r;
-    _str t;
     _uint m, d, n;
 
+    if (!(tok[i].kind == '-' && tok[i+1].kind == '-'))
+        return 0;
+    i += 2;
+
     /* --MMDD */
-    if (__match_str(&t, (t = text), textend, "--", 2) == 2
-        && __read_dec(&n, &t, t, textend) == 4) {
+    if (__tok_dec(&n, tok, i, 4, 4)) {
         d = n % 100;
         m = n / 100;
+        i += 1;
     }
     /* --[M]M<-/>[D]D */
-    else if (__match_str(&t, (t = text), textend, "--", 2) == 2
-             && (r = __read_dec(&m, &t, t, textend)) > 0 && r <= 2
-             && __match_chars_set(&t, t, textend, "-/", 2, 1, 1) == 1
-             && (r = __read_dec(&d, &t, t, textend)) > 0 && r <= 2) {
+    else if (__tok_dec(&m, tok, i, 1, 2)
+             && __tok_is(tok, i+1, '-', '/')
+             && __tok_dec(&d, tok, i+2, 1, 2)) {
+        i += 3;
     }
     else
         return 0;
 
-    *next = t;
+    *next = i;
 
     /* 1-1..12-31 */
     if (!(m > 0 && m <= 12
@@ -654,144 +1423,117 @@ static int __read_iso8601_MD(_ymd *val, _str *next, _str text, _str textend)
     val->year = _Y_DEFAULT;
     val->month = (_sint)m;
     val->day = (_sint)d;
-    return (int)(*next - text);
+    return 1;
 }
 
-/* `Z` */
-static int __read_iso8601_Z(_tz *val, _str *next, _str text, _str textend)
+/* Recognize a modified ISO 8601 date, any of them. */
+static int __tok_iso8601_date(_ymd *val, int *next, const _tok *tok, int i)
 {
-    _str t = text;
-
-    if (!(__match_chars_set(&t, t, textend, "Z", 1, 1, 1) > 0))
-        return 0;
+    int r;
 
-    memcpy(val, &_TZ_0, sizeof(*val));
-    return (int)((*next = t) - text);
+    if ((r = __tok_iso8601_YMD(val, next, tok, i)) == 0
+        && (r = __tok_iso8601_YM(val, next, tok, i)) == 0
+        && (r = __tok_iso8601_Y(val, next, tok, i)) == 0)
+        r = __tok_iso8601_MD(val, next, tok, i);
+    return r;
 }
 
-static int __read_iso8601_Zhm(_tz *val, _str *next, _str text, _str textend)
+/* Recognize a modified ISO 8601 timezone.
+
+  Z
+  <+->hhmm
+  <+->h{1..2}:m{1..2}
+  <+->h{1..2}
+
+[out] return: 1 if matched.
+              0 if none found. `next` untouched.
+              <0 if matched but wrong. `next` still progress.
+[out] val: Read value. Untouched on failure.
+[out] next: Index of the next token. Untouched if no match found.
+[in] tok, i: Tokens, and index to start with.
+*/
+static int __tok_iso8601_tz(_tz *val, int *next, const _tok *tok, int i)
 {
-    int r;
-    _str t;
     _sint sign, H, M;
     _uint h, m, n;
 
+    /* Z */
+    if (tok[i].kind == 'Z') {
+        *next = i+1;
+        memcpy(val, &_TZ_0, sizeof(*val));
+        return 1;
+    }
+    if (!__tok_is(tok, i, '+', '-'))
+        return 0;
+    i = __tok_sign(&sign, tok, i);
+
     /* <+->hhmm */
-    if (__read_sign(&sign, &t, (t = text), textend) == 1
-        && __read_dec(&n, &t, t, textend) == 4) {
+    if (__tok_dec(&n, tok, i, 4, 4)) {
         h = n / 100;
         m = n % 100;
+        i += 1;
     }
     /* <+->h{1..2}:m{1..2} */
-    else if (__read_sign(&sign, &t, (t = text), textend) == 1
-             && (r = __read_dec(&h, &t, t, textend)) > 0 && r <= 2
-             && __match_chars_set(&t, t, textend, ":", 2, 1, 1) == 1
-             && (r = __read_dec(&m, &t, t, textend)) > 0 && r <= 2) {
+    else if (__tok_dec(&h, tok, i, 1, 2)
+             && __tok_is(tok, i+1, ':', ':')
+             && __tok_dec(&m, tok, i+2, 1, 2)) {
+        i += 3;
+    }
+    /* <+->h{1..2} */
+    else if (__tok_dec(&h, tok, i, 1, 2)) {
+        m = 0;
+        i += 1;
     }
     else
         return 0;
 
-    *next = t;
+    *next = i;
     H = sign * (_sint)h;
     M = sign * (_sint)m;
 
     /* -12:00..+14:00 */
     if (!((H == _TZh_MIN && M == 0)
-          || (H == _TZh_MAX && M == 0) 
+          || (H == _TZh_MAX && M == 0)
           || (H > _TZh_MIN && H < _TZh_MAX && M > -60 && M < 60)))
         return CARGV_VAL_OVERFLOW;
 
     val->hour = H;
     val->minute = M;
-    return (int)(*next - text);
-}
-
-static int __read_iso8601_Zh(_tz *val, _str *next, _str text, _str textend)
-{
-    int r;
-    _str t;
-    _sint sign, H;
-    _uint h;
-
-    /* <+->H{1..2} */
-    if (__read_sign(&sign, &t, (t = text), textend) == 1
-        && (r = __read_dec(&h, &t, t, textend)) > 0 && r <= 2) {
-    }
-    else
-        return 0;
-
-    *next = t;
-    H = sign * (_sint)h;
-
-    /* -12..+14 */
-    if (!(H >= _TZh_MIN && H <= _TZh_MAX))
-        return CARGV_VAL_OVERFLOW;
-
-    val->hour = H;
-    val->minute = 0;
-    return (int)(*next - text);
-}
-
-/* Read a modified ISO 8601 timezone.
-
-[out] return: Number of characters succesfully read.
-              0 if none found. `next` untouched.
-              <0 if matched but wrong. `next` still progress.
-[out] val: Read value. Untouched on failure.
-[out] next: Points end of matched text. Untouched if no match found.
-[in] text, textend: Text to match.
-*/
-static int __read_iso8601_tz(_tz *val, _str *next, _str text, _str textend)
-{
-    int r;
-    _str t;
-    _tz v;
-
-    if ((r = __read_iso8601_Z(&v, &t, (t = text), textend)) == 0
-        && (r = __read_iso8601_Zhm(&v, &t, (t = text), textend)) == 0
-        && (r = __read_iso8601_Zh(&v, &t, (t = text), textend)) == 0)
-        return 0;
-
-    *next = t;
-    if (r < 0)
-        return r;
-
-    memcpy(val, &v, sizeof(*val));
-    return (int)(*next - text);
+    return 1;
 }
 
-/* Read a modified ISO 8601 hour, minute, and second, no omission.
+/* Recognize a modified ISO 8601 hour, minute, and second, no omission.
 
-[out] return: Number of characters succesfully read.
+[out] return: 1 if matched.
               0 if none found. `next` untouched.
               <0 if matched but wrong. `next` still progress.
 [out] val: Read value. Untouched on failure.
-[out] next: Points end of matched text. Untouched if no match found.
-[in] text, textend: Text to match.
+[out] next: Index of the next token. Untouched if no match found.
+[in] tok, i: Tokens, and index to start with.
 */
-static int __read_iso8601_hms(_hms *val, _str *next, _str text, _str textend)
+static int __tok_iso8601_hms(_hms *val, int *next, const _tok *tok, int i)
 {
-    int r;
-    _str t;
     _uint h, m, s, n;
 
     /* hhmmss[<.,>s[..3]] */
-    if (__read_dec(&n, &t, (t = text), textend) == 6) {
+    if (__tok_dec(&n, tok, i, 6, 6)) {
         h = n / 10000;
         m = (n % 10000) / 100;
         s = n % 100;
+        i += 1;
     }
     /* [h]h:[m]m:[s]s[<.,>s[..3]] */
-    else if ((r = __read_dec(&h, &t, (t = text), textend)) > 0 && r <= 2
-             && __match_chars_set(&t, t, textend, ":", 1, 1, 1) == 1
-             && (r = __read_dec(&m, &t, t, textend)) > 0 && r <= 2
-             && __match_chars_set(&t, t, textend, ":", 1, 1, 1) == 1
-             && (r = __read_dec(&s, &t, t, textend)) > 0 && r <= 2) {
+    else if (__tok_dec(&h, tok, i, 1, 2)
+             && __tok_is(tok, i+1, ':', ':')
+             && __tok_dec(&m, tok, i+2, 1, 2)
+             && __tok_is(tok, i+3, ':', ':')
+             && __tok_dec(&s, tok, i+4, 1, 2)) {
+        i += 5;
     }
     else
         return 0;
 
-    *next = t;
+    *next = i;
 
     /* 00:00:00..24:00:00 */
     if (!((h == 24 && m == 0 && s == 0) || (h < 24 && m < 60 && s < 60)))
@@ -801,38 +1543,38 @@ static int __read_iso8601_hms(_hms *val, _str *next, _str text, _str textend)
     val->minute = (_sint)m;
     val->second = (_sint)s;
     val->milisecond = 0;  /* todo */
-    return (int)(*next - text);
+    return 1;
 }
 
-/* Read a modified ISO 8601 hour and minute.
+/* Recognize a modified ISO 8601 hour and minute.
 
-[out] return: Number of characters succesfully read.
+[out] return: 1 if matched.
               0 if none found. `next` untouched.
               <0 if matched but wrong. `next` still progress.
 [out] val: Read value. Untouched on failure.
-[out] next: Points end of matched text. Untouched if no match found.
-[in] text, textend: Text to match.
+[out] next: Index of the next token. Untouched if no match found.
+[in] tok, i: Tokens, and index to start with.
 */
-static int __read_iso8601_hm(_hms *val, _str *next, _str text, _str textend)
+static int __tok_iso8601_hm(_hms *val, int *next, const _tok *tok, int i)
 {
-    int r;
-    _str t;
     _uint h, m, n;
 
     /* hhmm[.mmm] */
-    if (__read_dec(&n, &t, (t = text), textend) == 4) {
+    if (__tok_dec(&n, tok, i, 4, 4)) {
         h = n / 100;
         m = n % 100;
+        i += 1;
     }
     /* [h]h:[m]m[.mmm] */
-    else if ((r = __read_dec(&h, &t, (t = text), textend)) > 0 && r <= 2
-             && __match_chars_set(&t, t, textend, ":", 1, 1, 1) == 1
-             && (r = __read_dec(&m, &t, t, textend)) > 0 && r <= 2) {
+    else if (__tok_dec(&h, tok, i, 1, 2)
+             && __tok_is(tok, i+1, ':', ':')
+             && __tok_dec(&m, tok, i+2, 1, 2)) {
+        i += 3;
     }
     else
         return 0;
 
-    *next = t;
+    *next = i;
 
     /* 00:00..24:00 */
     if (!((h == 24 && m == 0) || (h < 24 && m < 60)))
@@ -842,31 +1584,30 @@ static int __read_iso8601_hm(_hms *val, _str *next, _str text, _str textend)
     val->minute = (_sint)m;
     val->second = 0;
     val->milisecond = 0;
-    return (int)(*next - text);
+    return 1;
 }
 
-/* Read a modified ISO 8601 hour only.
+/* Recognize a modified ISO 8601 hour only.
 
-[out] return: Number of characters succesfully read.
+[out] return: 1 if matched.
               0 if none found. `next` untouched.
               <0 if matched but wrong. `next` still progress.
 [out] val: Read value. Untouched on failure.
-[out] next: Points end of matched text. Untouched if no match found.
-[in] text, textend: Text to match.
+[out] next: Index of the next token. Untouched if no match found.
+[in] tok, i: Tokens, and index to start with.
 */
-static int __read_iso8601_h(_hms *val, _str *next, _str text, _str textend)
+static int __tok_iso8601_h(_hms *val, int *next, const _tok *tok, int i)
 {
-    int r;
-    _str t;
     _uint h;
 
     /* [h]h[.hhh] */
-    if ((r = __read_dec(&h, &t, (t = text), textend)) > 0 && r <= 2) {
+    if (__tok_dec(&h, tok, i, 1, 2)) {
+        i += 1;
     }
     else
         return 0;
 
-    *next = t;
+    *next = i;
 
     /* 00..24 */
     if (!(h <= 24))
@@ -876,49 +1617,389 @@ static int __read_iso8601_h(_hms *val, _str *next, _str text, _str textend)
     val->minute = 0;
     val->second = 0;
     val->milisecond = 0;
-    return (int)(*next - text);
+    return 1;
 }
 
-/* Read a modified ISO 6709 degree.
+/* Recognize a modified ISO 8601 time, any of them. */
+static int __tok_iso8601_time(_hms *val, int *next, const _tok *tok, int i)
+{
+    int r;
 
-[out] return: Number of characters succesfully read.
-              0 if none found. `next` untouched.
-              <0 if matched but wrong. `next` still progress.
-[out] val: Read value. Untouched on failure.
-[out] next: Points end of matched text. Untouched if no match found.
-[in] text, textend: Text to match.
+    if ((r = __tok_iso8601_hms(val, next, tok, i)) == 0
+        && (r = __tok_iso8601_hm(val, next, tok, i)) == 0)
+        r = __tok_iso8601_h(val, next, tok, i);
+    return r;
+}
+
+/* Read a date argument. See cargv_date().
+
+[out] return: 1 if read, 0 if not matched, <0 if matched but wrong.
 */
-static int __read_iso6709_degree(
-    _degree *val, _str *next, _str text, _str textend)
+static int __arg_date(_ymd *d, _str text, _str textend)
 {
-    _str t, tf;
-    int rn, rf;
-    _sint sign;
-    _uint n, f;
-    _sint d, m, s, df, mf, sf;
+    _tok tok[_TOK_MAX+2];
+    int n, i, r;
 
-    /* <+-> */
-    if (!(__read_sign(&sign, &t, (t = text), textend) == 1))
+    if ((n = __lex_iso8601(tok, text, textend)) > _TOK_MAX)
         return 0;
-
-    /* Integer part: d[..] */
-    if (!((rn = __read_dec(&n, &t, t, textend)) > 0))
+    if ((r = __tok_iso8601_date(d, &i, tok, 0)) == 0 || i != n)
         return 0;
+    return r;
+}
 
-    /* Fraction part: [<.,>d[..]] */
-    if (__match_chars_set(&tf, (tf = t), textend, ".,", 2, 1, 1) == 1
-        && (rf = __read_dec(&f, &tf, tf, textend)) > 0) {
-        t = tf;
-    }
-    else {
-        rf = 0;
-        f = 0;
-    }
+/* Read a time argument. See cargv_time().
 
-    *next = t;
+[out] return: 1 if read, 0 if not matched, <0 if matched but wrong.
+*/
+static int __arg_time(_hms *h, _tz *tz, _str text, _str textend)
+{
+    _tok tok[_TOK_MAX+2];
+    int n, i, rh, rz;
 
-    /* D[..3][<.,>D[..6]] */
-    if (rn >= 1 && rn <= 3 && rf <= 6) {
+    if ((n = __lex_iso8601(tok, text, textend)) > _TOK_MAX)
+        return 0;
+
+    /* <hms>[z] */
+    if ((rh = __tok_iso8601_time(h, &i, tok, 0)) == 0)
+        return 0;
+    if ((rz = __tok_iso8601_tz(tz, &i, tok, i)) == 0)
+        memcpy(tz, &_TZ_DEFAULT, sizeof(*tz));
+    if (i != n)
+        return 0;
+    return (rh < 0) ? rh : rz < 0 ? rz : 1;
+}
+
+/* Read a timezone argument. See cargv_timezone().
+
+[out] return: 1 if read, 0 if not matched, <0 if matched but wrong.
+*/
+static int __arg_timezone(_tz *tz, _str text, _str textend)
+{
+    _tok tok[_TOK_MAX+2];
+    int n, i, r;
+
+    if ((n = __lex_iso8601(tok, text, textend)) > _TOK_MAX)
+        return 0;
+    if ((r = __tok_iso8601_tz(tz, &i, tok, 0)) == 0 || i != n)
+        return 0;
+    return r;
+}
+
+/* Read a datetime argument. See cargv_datetime().
+
+[out] return: 1 if read, 0 if not matched, <0 if matched but wrong.
+*/
+static int __arg_datetime(_ymd *d, _hms *h, _tz *tz, _str text, _str textend)
+{
+    _tok tok[_TOK_MAX+2];
+    int n, i, rd, rh, rz;
+
+    if ((n = __lex_iso8601(tok, text, textend)) > _TOK_MAX)
+        return 0;
+
+    rd = rh = rz = 0;
+
+    /* <date>T<time>[tz] */
+    if ((rd = __tok_iso8601_date(d, &i, tok, 0)) != 0
+        && __tok_is(tok, i, 'T', ' ')
+        && (rh = __tok_iso8601_time(h, &i, tok, i+1)) != 0) {
+        if ((rz = __tok_iso8601_tz(tz, &i, tok, i)) == 0)
+            memcpy(tz, &_TZ_DEFAULT, sizeof(*tz));
+    }
+    /* <date> */
+    else if ((rd = __tok_iso8601_YMD(d, &i, tok, 0)) != 0
+             || (rd = __tok_iso8601_YM(d, &i, tok, 0)) != 0
+             || (rd = __tok_iso8601_MD(d, &i, tok, 0)) != 0) {
+        rh = rz = 0;
+        memcpy(h, &_HMS_DEFAULT, sizeof(*h));
+        memcpy(tz, &_TZ_DEFAULT, sizeof(*tz));
+    }
+    /* <time>[tz] */
+    else if ((rh = __tok_iso8601_hms(h, &i, tok, 0)) != 0
+             || (rh = __tok_iso8601_hm(h, &i, tok, 0)) != 0) {
+        memcpy(d, &_YMD_DEFAULT, sizeof(*d));
+        if ((rz = __tok_iso8601_tz(tz, &i, tok, i)) == 0)
+            memcpy(tz, &_TZ_DEFAULT, sizeof(*tz));
+    }
+    /* <hour><tz> */
+    else if ((rh = __tok_iso8601_h(h, &i, tok, 0)) != 0
+             && (rz = __tok_iso8601_tz(tz, &i, tok, i)) != 0) {
+        memcpy(d, &_YMD_DEFAULT, sizeof(*d));
+    }
+    /* <year> */
+    else if ((rd = __tok_iso8601_Y(d, &i, tok, 0)) != 0) {
+        rh = rz = 0;
+        memcpy(h, &_HMS_DEFAULT, sizeof(*h));
+        memcpy(tz, &_TZ_DEFAULT, sizeof(*tz));
+    }
+    else
+        return 0;
+
+    if (i != n)
+        return 0;
+    return (rd < 0) ? rd : (rh < 0) ? rh : (rz < 0) ? rz : 1;
+}
+
+/* Fixed-width datetime formats. See cargv_datetime_format().
+
+Digits of an argument are gathered into a 64bit word, validated and
+converted two by two at once, into fields at known offsets.
+*/
+#define _FMT_DATE   0x1
+#define _FMT_TIME   0x2
+
+static const struct _fmt_t {
+    signed char len;    /* Length of the argument */
+    signed char date;   /* Offset of the date, -1 if none */
+    signed char time;   /* Offset of the time, -1 if none */
+    char ext;           /* 1 if with separators, `-` and `:` */
+    char z;             /* 1 if ends with `Z` */
+} __fmt[CARGV_FORMAT_COUNT] = {
+    {  0, -1, -1, 0, 0 },   /* ANY */
+    {  8,  0, -1, 0, 0 },   /* YYYYMMDD */
+    { 10,  0, -1, 1, 0 },   /* YYYY-MM-DD */
+    {  6, -1,  0, 0, 0 },   /* hhmmss */
+    {  8, -1,  0, 1, 0 },   /* hh:mm:ss */
+    { 15,  0,  9, 0, 0 },   /* YYYYMMDDThhmmss */
+    { 16,  0,  9, 0, 1 },   /* YYYYMMDDThhmmssZ */
+    { 19,  0, 11, 1, 0 },   /* YYYY-MM-DDThh:mm:ss */
+    { 20,  0, 11, 1, 1 },   /* YYYY-MM-DDThh:mm:ssZ */
+};
+
+/* Convert 8 digits to 4 pairs of digits.
+
+[out] return: 1 if all are digits, else 0.
+[out] pairs: Values of digit pairs, 0..99.
+[in]  text: 8 characters.
+*/
+static int __fmt_pairs(_uint pairs[4], const char *text)
+{
+#ifdef _HAVE_SWAR_DEC
+    uint64_t x;
+
+    memcpy(&x, text, sizeof(x));
+    if ((x & UINT64_C(0xF0F0F0F0F0F0F0F0)) != UINT64_C(0x3030303030303030)
+        || ((x + UINT64_C(0x0606060606060606)) & UINT64_C(0xF0F0F0F0F0F0F0F0))
+           != UINT64_C(0x3030303030303030))
+        return 0;
+    x -= UINT64_C(0x3030303030303030);
+    x = (x * 10 + (x >> 8)) & UINT64_C(0x00FF00FF00FF00FF);
+    pairs[0] = (_uint)(x & 0xFF);
+    pairs[1] = (_uint)((x >> 16) & 0xFF);
+    pairs[2] = (_uint)((x >> 32) & 0xFF);
+    pairs[3] = (_uint)(x >> 48);
+    return 1;
+#else
+    int i;
+
+    for (i = 0; i < 8; ++i) {
+        if (!__char_is(text[i], _CC_DIGIT))
+            return 0;
+    }
+    for (i = 0; i < 4; ++i)
+        pairs[i] = (_uint)(text[i*2] - '0') * 10 + (_uint)(text[i*2+1] - '0');
+    return 1;
+#endif
+}
+
+/* Read a datetime argument in a fixed-width format.
+
+[out] return: 1 if read, 0 if not in the format, <0 if in it but wrong.
+              Same as __arg_datetime() for arguments in the format.
+[out] d, h, tz: Read value. Omitted parts are in default values.
+[in]  format: cargv_datetime_format_t.
+[in]  parts: _FMT_DATE and _FMT_TIME the reader reads.
+*/
+static int __fmt_datetime(
+    int format, int parts, _ymd *d, _hms *h, _tz *tz,
+    _str text, _str textend)
+{
+    const struct _fmt_t *f;
+    char dig[8];
+    _uint dp[4], hp[4];
+    _str t;
+
+    if (!(format > CARGV_FORMAT_ANY && format < CARGV_FORMAT_COUNT))
+        return 0;
+    f = &__fmt[format];
+    if (!(textend - text == f->len
+          && (f->date < 0 || (parts & _FMT_DATE))
+          && (f->time < 0 || (parts & _FMT_TIME))))
+        return 0;
+    if (f->z && text[f->len-1] != 'Z')
+        return 0;
+    if (f->date >= 0 && f->time >= 0
+        && !__char_is(text[f->time-1], _CC_T))
+        return 0;
+
+    /* Digits of the date and the time, 8 each */
+    if (f->date >= 0) {
+        t = text + f->date;
+        if (f->ext) {
+            if (!(t[4] == '-' && t[7] == '-'))
+                return 0;
+            memcpy(dig, t, 4);
+            memcpy(dig+4, t+5, 2);
+            memcpy(dig+6, t+8, 2);
+        }
+        else
+            memcpy(dig, t, 8);
+        if (!__fmt_pairs(dp, dig))
+            return 0;
+    }
+    if (f->time >= 0) {
+        t = text + f->time;
+        if (f->ext) {
+            if (!(t[2] == ':' && t[5] == ':'))
+                return 0;
+            memcpy(dig, t, 2);
+            memcpy(dig+2, t+3, 2);
+            memcpy(dig+4, t+6, 2);
+        }
+        else
+            memcpy(dig, t, 6);
+        dig[6] = dig[7] = '0';
+        if (!__fmt_pairs(hp, dig))
+            return 0;
+    }
+
+    memcpy(d, &_YMD_DEFAULT, sizeof(*d));
+    memcpy(h, &_HMS_DEFAULT, sizeof(*h));
+    memcpy(tz, f->z ? &_TZ_0 : &_TZ_DEFAULT, sizeof(*tz));
+
+    /* -9999-1-1..+9999-12-31 */
+    if (f->date >= 0) {
+        d->year = (_sint)(dp[0] * 100 + dp[1]);
+        d->month = (_sint)dp[2];
+        d->day = (_sint)dp[3];
+        if (!(d->month > 0 && d->month <= 12
+              && d->day > 0
+              && d->day <= __days_of_month(d->year, dp[2])))
+            return CARGV_VAL_OVERFLOW;
+    }
+    /* 00:00:00..24:00:00 */
+    if (f->time >= 0) {
+        h->hour = (_sint)hp[0];
+        h->minute = (_sint)hp[1];
+        h->second = (_sint)hp[2];
+        h->milisecond = 0;
+        if (!((hp[0] == 24 && hp[1] == 0 && hp[2] == 0)
+              || (hp[0] < 24 && hp[1] < 60 && hp[2] < 60)))
+            return CARGV_VAL_OVERFLOW;
+    }
+    return 1;
+}
+
+/* Guess a fixed-width format of an argument by its length and separators.
+
+The guess is not validated. See __fmt_datetime().
+
+[out] return: cargv_datetime_format_t. CARGV_FORMAT_ANY if none.
+*/
+static int __fmt_guess(_str text, _str textend)
+{
+    switch (textend - text) {
+    case 6:     return CARGV_FORMAT_TIME_BASIC;
+    case 8:     return (text[2] == ':') ? CARGV_FORMAT_TIME_EXTENDED
+                                        : CARGV_FORMAT_DATE_BASIC;
+    case 10:    return CARGV_FORMAT_DATE_EXTENDED;
+    case 15:    return CARGV_FORMAT_DATETIME_BASIC;
+    case 16:    return CARGV_FORMAT_DATETIME_BASIC_Z;
+    case 19:    return CARGV_FORMAT_DATETIME_EXTENDED;
+    case 20:    return CARGV_FORMAT_DATETIME_EXTENDED_Z;
+    }
+    return CARGV_FORMAT_ANY;
+}
+
+/* Read a datetime argument, in a format or predicting one.
+
+With CARGV_FORMAT_ANY, the format predicted by cargv is tried first. On a
+miss, the argument is read by the general readers, and its format guessed
+to train the prediction. A 2bit saturating confidence keeps a prediction
+over a few arguments in other formats, as a branch predictor does.
+
+[out] return: 1 if read, 0 if not matched, <0 if matched but wrong.
+[in]  parts: _FMT_DATE and _FMT_TIME the reader reads.
+*/
+static int __predict_datetime(
+    struct cargv_t *cargv, int format, int parts,
+    _ymd *d, _hms *h, _tz *tz, _str text, _str textend)
+{
+    int r, g;
+
+    if (format == CARGV_FORMAT_ANY) {
+        if ((r = __fmt_datetime(cargv->predict, parts, d, h, tz,
+                                text, textend)) != 0) {
+            ++cargv->predict_hits;
+            if (cargv->predict_conf < 3)
+                ++cargv->predict_conf;
+            return r;
+        }
+        ++cargv->predict_misses;
+    }
+    else if ((r = __fmt_datetime(format, parts, d, h, tz,
+                                 text, textend)) != 0)
+        return r;
+
+    if (parts == _FMT_DATE)
+        r = __arg_date(d, text, textend);
+    else if (parts == _FMT_TIME)
+        r = __arg_time(h, tz, text, textend);
+    else
+        r = __arg_datetime(d, h, tz, text, textend);
+
+    if (format == CARGV_FORMAT_ANY && r != 0) {
+        g = __fmt_guess(text, textend);
+        if (cargv->predict_conf > 0)
+            --cargv->predict_conf;
+        else if (g != CARGV_FORMAT_ANY) {
+            cargv->predict = g;
+            cargv->predict_conf = 1;
+        }
+    }
+    return r;
+}
+
+/* Read a modified ISO 6709 degree.
+
+[out] return: Number of characters succesfully read.
+              0 if none found. `next` untouched.
+              <0 if matched but wrong. `next` still progress.
+[out] val: Read value. Untouched on failure.
+[out] next: Points end of matched text. Untouched if no match found.
+[in] text, textend: Text to match.
+*/
+static int __read_iso6709_degree(
+    _degree *val, _str *next, _str text, _str textend)
+{
+    _str t, tf;
+    int rn, rf;
+    _sint sign;
+    _uint n, f;
+    _sint d, m, s, df, mf, sf;
+
+    /* <+-> */
+    if (!(__read_sign(&sign, &t, (t = text), textend) == 1))
+        return 0;
+
+    /* Integer part: d[..] */
+    if (!((rn = __read_dec(&n, &t, t, textend)) > 0))
+        return 0;
+
+    /* Fraction part: [<.,>d[..]] */
+    if (__match_chars(&tf, (tf = t), textend, _CC_FRAC, 1, 1) == 1
+        && (rf = __read_dec(&f, &tf, tf, textend)) > 0) {
+        t = tf;
+    }
+    else {
+        rf = 0;
+        f = 0;
+    }
+
+    *next = t;
+
+    /* D[..3][<.,>D[..6]] */
+    if (rn >= 1 && rn <= 3 && rf <= 6) {
         d = (_sint)n;
         df = (_sint)f / __p10(rf-6) * __p10(6-rf);
         m = mf = 0;
@@ -975,7 +2056,7 @@ static int __read_iso6709_geocoord(
     /* <latitude><longitude>[/] */
     if ((ry = __read_iso6709_degree(&y, &t, (t = text), textend)) != 0
         && (rx = __read_iso6709_degree(&x, &t, t, textend)) != 0
-        && __match_chars_set(&t, t, textend, "/", 1, 0, 1) >= 0) {
+        && __match_chars(&t, t, textend, _CC_SLASH, 0, 1) >= 0) {
     }
     else
         return 0;
@@ -985,7 +2066,7 @@ static int __read_iso6709_geocoord(
     if (ry < 0)
         return ry;
     if (rx < 0)
-        return ry;
+        return rx;
     if (!(y.degree >= -90 && y.degree <= 90
           && x.degree >= -180 && x.degree <= 180))
         return CARGV_VAL_OVERFLOW;
@@ -995,525 +2076,3695 @@ static int __read_iso6709_geocoord(
     return (int)(*next - text);
 }
 
+/* Argument cursor.
+
+Walks arguments of a cargv object, whether they are from argv or a buffer.
+*/
+typedef struct _cursor_t {
+    _str *arg, *argend;     /* argv source */
+    _len *len;              /* lengths of argv, if not null */
+    _str buf, bufend;       /* buffer source, if buf is not null */
+    _str tokend;            /* end of the current argument in buf */
+    char delim;
+    _len i;                 /* index of the current argument */
+} _cursor;
+
+static void __cursor_init(_cursor *cur, const struct cargv_t *cargv)
+{
+    cur->arg = cargv->args;
+    cur->argend = cargv->argend;
+    cur->len = cargv->lens;
+    cur->buf = cargv->buf;
+    cur->bufend = cargv->bufend;
+    cur->tokend = NULL;
+    cur->delim = cargv->delim;
+    cur->i = 0;
+}
+
+/* Get the current argument.
+
+[out] return: 1 if an argument is there, 0 if ran out.
+[out] text, textend: The argument. Untouched if ran out.
+*/
+static int __cursor_get(_cursor *cur, _str *text, _str *textend)
+{
+    if (cur->buf) {
+        if (!(cur->buf < cur->bufend))
+            return 0;
+        cur->tokend = __find_char(cur->buf, cur->bufend, cur->delim);
+        *text = cur->buf;
+        *textend = cur->tokend;
+        return 1;
+    }
+    if (!(cur->arg < cur->argend))
+        return 0;
+    *text = *cur->arg;
+    if (cur->len) {
+        if (*cur->len < 0)
+            *cur->len = (_len)strlen(*text);
+        *textend = *text + *cur->len;
+    }
+    else
+        *textend = *text + strlen(*text);
+    return 1;
+}
+
+/* Move to the next argument. Call after __cursor_get() succeeded. */
+static void __cursor_next(_cursor *cur)
+{
+    ++cur->i;
+    if (cur->buf)
+        cur->buf = (cur->tokend < cur->bufend) ? cur->tokend + 1 : cur->bufend;
+    else {
+        ++cur->arg;
+        if (cur->len)
+            ++cur->len;
+    }
+}
+
+#define _ERR_FMT_OVERFLOW  "%s: %s `%s` overflows, which is `%.*s`.\n"
+#define _ERR_FMT_UNKNOWN \
+    "%s: Unknown error reading %s `%s`, which is `%.*s`.\n"
+
 static int err_val_result(
     struct cargv_t *cargv,
     const char *name,
     const char *type,
-    _str arg,
+    _len index,
+    _str arg, _str argend,
     int result)
 {
+    struct cargv_error_sink_t *sink;
+    struct cargv_error_t err;
+    _len n;
+
     if (result < 0) {
-        if (result == CARGV_VAL_OVERFLOW) {
+        err.code = result;
+        err.type = type;
+        err.name = name;
+        err.index = cargv->argi + index;
+        err.offset = cargv->buf
+            ? (_len)(arg - cargv->bufbase) + cargv->bufoff : -1;
+        err.len = argend - arg;
+        n = (err.len < CARGV_ERROR_ARG_MAX) ? err.len : CARGV_ERROR_ARG_MAX-1;
+        memcpy(err.arg, arg, (size_t)n);
+        err.arg[n] = '\0';
+
+        if (!(sink = cargv->errsink)) {
             fprintf(stderr,
-                "%s: %s `%s` overflows, which is `%s`.\n",
-                cargv->name, type, name, arg);
+                (result == CARGV_VAL_OVERFLOW)
+                    ? _ERR_FMT_OVERFLOW : _ERR_FMT_UNKNOWN,
+                cargv->name, type, name, (int)err.len, arg);
         }
         else {
-            fprintf(stderr,
-                "%s: Unknown error reading %s `%s`, which is `%s`.\n",
-                cargv->name, type, name, arg);
+            if (sink->fn)
+                sink->fn(sink->ctx, &err);
+            else if (sink->ringc > 0)
+                memcpy(&sink->ring[sink->count % sink->ringc], &err,
+                       sizeof(err));
+            ++sink->count;
         }
     }
     return result;
 }
 
-
-enum cargv_err_t
-cargv_init(
-    struct cargv_t *cargv,
-    const char *name,
-    int argc, const char **argv)
-{
-    cargv->name = name;
-    cargv->args = argv;
-    cargv->argend = argv + argc;
-    return CARGV_OK;
-}
-
-int cargv_len(const struct cargv_t *cargv)
+cargv_len_t cargv_format_error(
+    char *buf, cargv_len_t bufc,
+    const struct cargv_t *cargv,
+    const struct cargv_error_t *err)
 {
-    return (int)(cargv->argend - cargv->args);
-}
+    char dummy[1];
 
-int cargv_shift(struct cargv_t *cargv, cargv_len_t argc)
-{
-    if (argc > 0 && cargv->args + argc <= cargv->argend) {
-        cargv->args += argc;
-        return (int)argc;
+    if (bufc <= 0) {
+        buf = dummy;
+        bufc = 1;
     }
-    return 0;
+    return snprintf(buf, (size_t)bufc,
+        (err->code == CARGV_VAL_OVERFLOW)
+            ? _ERR_FMT_OVERFLOW : _ERR_FMT_UNKNOWN,
+        cargv->name, err->type, err->name, (int)strlen(err->arg), err->arg);
 }
 
-int cargv_opt(struct cargv_t *cargv, const char *optlist)
-{
-    _str lopt, oend, o;
-    _str aend, a;
-    int wildcard;
-
-    if (!(cargv->args < cargv->argend))
-        return 0;
+/* Arena.
 
-    aend = *cargv->args + strlen(*cargv->args);
-    oend = optlist + strlen(optlist);
+Blocks are linked from the newest, each headed by a link padded to the
+alignment. Allocations larger than a quarter of a block get a block of their
+own, leaving the current block to bump from, so its rest is not wasted.
+*/
+#define _ARENA_ALIGN  16
 
-    /* Argument is short option of `*`, default `-*`, matches any option */
-    o = optlist;
-    wildcard = __match_str(&o, o, oend, "-", 1)
-               && __match_str(&o, o, oend, "*", 1)
-               && __match_end(o, oend);
+struct cargv_arena_block_t {
+    struct cargv_arena_block_t *next;
+};
 
-    /* Split optlist */
-    o = optlist;
-    __unmatch_str(&lopt, o, oend, "--", 2);
+#define _ARENA_HEAD \
+    ((sizeof(struct cargv_arena_block_t) + _ARENA_ALIGN-1) \
+        & ~(size_t)(_ARENA_ALIGN-1))
 
-    /* Argument is long option, like `--long-option` */
-    a = *cargv->args;
-    if (__match_str(&a, a, aend, "--", 2)) {
-        if (__match_end(a, aend))
-            return 0;   /* -- */
-        if (wildcard)
-            return 1;
+void cargv_arena_init(
+    struct cargv_arena_t *arena,
+    void *mem, cargv_len_t memsize,
+    cargv_len_t blocksize)
+{
+    arena->blocks = NULL;
+    arena->mem = (char *)mem;
+    arena->memsize = (mem && memsize > 0) ? memsize : 0;
+    arena->blocksize = (blocksize > 0) ? blocksize : CARGV_ARENA_BLOCK;
+    arena->cur = arena->mem;
+    arena->end = arena->mem + arena->memsize;
+}
 
-        /* Iterate long options */
-        o = lopt;
-        while (o < oend) {
-            o += 2;   /* already matched */
-            __unmatch_str(&lopt, o, oend, "--", 2);
-            if (__match_str(&a, a, aend, o, lopt-o) && __match_end(a, aend))
-                return 1;
-            o = lopt;
+void *cargv_arena_alloc(struct cargv_arena_t *arena, cargv_len_t size)
+{
+    struct cargv_arena_block_t *b;
+    size_t pad, n;
+    char *p;
+
+    if (size < 0)
+        return NULL;
+    if (size == 0)
+        size = 1;
+    size = (size + _ARENA_ALIGN-1) & ~(cargv_len_t)(_ARENA_ALIGN-1);
+
+    if (arena->cur) {
+        pad = (size_t)(-(uintptr_t)arena->cur & (_ARENA_ALIGN-1));
+        if ((size_t)(arena->end - arena->cur) >= pad + (size_t)size) {
+            p = arena->cur + pad;
+            arena->cur = p + size;
+            return p;
         }
     }
-    /* Argument is short option, like `-s` */
-    else if (__match_str(&a, a, aend, "-", 1)) {
-        if (__match_end(a, aend))
-            return 0;   /* - */
-        if (wildcard)
-            return 1;
 
-        /* Find in short options */
-        o = optlist;
-        if (__match_str(&o, o, lopt, "-", 1)
-            && __match_chars_set(&a, a, aend, o, lopt-o, 1, lopt-o)
-            && __match_end(a, aend))
-            return 1;
+    if (size > arena->blocksize / 4) {
+        if (!(b = (struct cargv_arena_block_t *)malloc(
+                _ARENA_HEAD + (size_t)size)))
+            return NULL;
+        b->next = arena->blocks;
+        arena->blocks = b;
+        return (char *)b + _ARENA_HEAD;
     }
-    return 0;
+
+    n = _ARENA_HEAD + (size_t)arena->blocksize;
+    if (!(b = (struct cargv_arena_block_t *)malloc(n)))
+        return NULL;
+    b->next = arena->blocks;
+    arena->blocks = b;
+    p = (char *)b + _ARENA_HEAD;
+    arena->cur = p + size;
+    arena->end = (char *)b + n;
+    return p;
 }
 
-int cargv_text(
-    struct cargv_t *cargv,
-    const char *name,
-    const char **vals, cargv_len_t valc)
+void cargv_arena_release(struct cargv_arena_t *arena)
 {
-    _str *v, *a;
-    (void)name;
+    struct cargv_arena_block_t *b, *next;
 
-    a = cargv->args;
-    v = vals;
-    while (a < cargv->argend && v - vals < valc)
-        *v++ = *a++;
+    for (b = arena->blocks; b; b = next) {
+        next = b->next;
+        free(b);
+    }
+    arena->blocks = NULL;
+    arena->cur = arena->mem;
+    arena->end = arena->mem + arena->memsize;
+}
 
-    return (int)(v-vals);
+void cargv_set_arena(
+    struct cargv_t *cargv,
+    struct cargv_arena_t *arena)
+{
+    cargv->arena = arena;
 }
 
-int cargv_oneof(
+void cargv_set_error_sink(
     struct cargv_t *cargv,
-    const char *name,
-    const char *list, const char *sep,
-    const char **vals, cargv_len_t valc)
+    struct cargv_error_sink_t *sink)
 {
-    _str *val, *arg;
-    _str listend, t, tend;
-    _str aend, a;
-    _len seplen;
-    (void)name;
+    cargv->errsink = sink;
+}
 
-    listend = list + strlen(list);
-    seplen = (_len)strlen(sep);
+void cargv_error_sink_callback(
+    struct cargv_error_sink_t *sink,
+    cargv_error_fn *fn, void *ctx)
+{
+    sink->fn = fn;
+    sink->ctx = ctx;
+    sink->ring = NULL;
+    sink->ringc = 0;
+    sink->count = 0;
+}
 
-    val = vals;
-    arg = cargv->args;
-    while (val - vals < valc && arg < cargv->argend) {
-        aend = *arg + strlen(*arg);
-        a = *arg;
-        t = list;
-        while (t < listend) {
-            __unmatch_str(&tend, t, listend, sep, seplen);
-            if (__match_str(&a, a, aend, t, tend-t) && __match_end(a, aend))
-                break;
-            t = tend + seplen;
-        }
-        if (t < listend)    /* found */
-            *val++ = *arg;
-        else
-            break;
-        arg++;
-    }
-    return (int)(val-vals);
+void cargv_error_sink_ring(
+    struct cargv_error_sink_t *sink,
+    struct cargv_error_t *ring, cargv_len_t ringc)
+{
+    sink->fn = NULL;
+    sink->ctx = NULL;
+    sink->ring = ring;
+    sink->ringc = (ring && ringc > 0) ? ringc : 0;
+    sink->count = 0;
 }
 
-int cargv_int(
+enum cargv_err_t cargv_error_sink_alloc(
+    struct cargv_error_sink_t *sink,
     struct cargv_t *cargv,
-    const char *name,
-    cargv_int_t *vals, cargv_len_t valc)
+    cargv_len_t ringc)
 {
-    int r;
-    _sint *v, n;
-    _str *a, t, e;
+    struct cargv_error_t *ring;
+
+    if (!cargv->arena || ringc <= 0)
+        return CARGV_BAD_PARAM;
+    if ((size_t)ringc > (size_t)-1 / sizeof(*ring))
+        return CARGV_NO_MEMORY;
+    if (!(ring = (struct cargv_error_t *)cargv_arena_alloc(
+            cargv->arena, ringc * (cargv_len_t)sizeof(*ring))))
+        return CARGV_NO_MEMORY;
+    cargv_error_sink_ring(sink, ring, ringc);
+    cargv->errsink = sink;
+    return CARGV_OK;
+}
 
-    a = cargv->args;
-    v = vals;
-    while (a < cargv->argend && v - vals < valc) {
-        t = *a;
-        e = t + strlen(t);
-        if ((r = __read_sint_dec(&n, &t, t, e)) == 0)
-            break;
-        if (!__match_end(t, e))
-            break;
-        if (r < 0)
-            return err_val_result(cargv, name, "integer", *a, r);
+const struct cargv_error_t *cargv_error_at(
+    const struct cargv_error_sink_t *sink,
+    cargv_len_t i)
+{
+    _len kept, first;
 
-        *v++ = n;
-        a++;
-    }
-    return (int)(v-vals);
+    kept = (sink->count < sink->ringc) ? sink->count : sink->ringc;
+    if (!(i >= 0 && i < kept))
+        return NULL;
+    first = sink->count - kept;
+    return &sink->ring[(first + i) % sink->ringc];
 }
 
-int cargv_uint(
+
+enum cargv_err_t
+cargv_init(
+    struct cargv_t *cargv,
+    const char *name,
+    int argc, const char **argv)
+{
+    return cargv_init_lens(cargv, name, argc, argv, NULL);
+}
+
+enum cargv_err_t
+cargv_init_lens(
+    struct cargv_t *cargv,
+    const char *name,
+    int argc, const char **argv,
+    cargv_len_t *lens)
+{
+    cargv->name = name;
+    cargv->args = argv;
+    cargv->argend = argv + argc;
+    cargv->lens = lens;
+    cargv->buf = cargv->bufend = cargv->bufbase = NULL;
+    cargv->bufc = 0;
+    cargv->delim = 0;
+    cargv->fd = -1;
+    cargv->win = NULL;
+    cargv->winsize = 0;
+    cargv->fillend = NULL;
+    cargv->bufoff = 0;
+    cargv->eof = 1;
+    cargv->argi = 0;
+    cargv->errsink = NULL;
+    cargv->arena = NULL;
+    cargv->predict = CARGV_FORMAT_ANY;
+    cargv->predict_conf = 0;
+    cargv->predict_hits = cargv->predict_misses = 0;
+    return CARGV_OK;
+}
+
+enum cargv_err_t
+cargv_init_buffer(
+    struct cargv_t *cargv,
+    const char *name,
+    const char *buf, cargv_len_t buflen, char delim)
+{
+    static const char empty[] = "";
+
+    if (buflen < 0 || (!buf && buflen > 0))
+        return CARGV_BAD_PARAM;
+    if (!buf)
+        buf = empty;
+
+    cargv_init_lens(cargv, name, 0, NULL, NULL);
+    cargv->buf = cargv->bufbase = buf;
+    cargv->bufend = buf + buflen;
+    cargv->delim = delim;
+
+    /* Every delimiter ends an argument, and so does the end of buffer. */
+    cargv->bufc = __count_char(cargv->buf, cargv->bufend, delim);
+    if (buflen > 0 && cargv->bufend[-1] != delim)
+        ++cargv->bufc;
+    return CARGV_OK;
+}
+
+/* Stream source.
+
+The window holds data read so far from buf to fillend. buf..bufend are
+complete arguments, and bufend..fillend is the start of the next one.
+*/
+
+/* Set bufend and bufc by complete arguments in the window. */
+static void __stream_scan(struct cargv_t *cargv)
+{
+    _str e;
+
+    if (cargv->eof) {
+        cargv->bufend = cargv->fillend;
+        cargv->bufc = __count_char(cargv->buf, cargv->bufend, cargv->delim);
+        if (cargv->buf < cargv->bufend && cargv->bufend[-1] != cargv->delim)
+            ++cargv->bufc;
+        return;
+    }
+    for (e = cargv->fillend; e > cargv->buf && e[-1] != cargv->delim; --e) {
+    }
+    cargv->bufend = e;
+    cargv->bufc = __count_char(cargv->buf, cargv->bufend, cargv->delim);
+}
+
+/* Stop the stream after an error, dropping a partial argument. */
+static int __stream_fail(struct cargv_t *cargv, int err)
+{
+    cargv->fillend = cargv->bufend;
+    cargv->eof = 1;
+    __stream_scan(cargv);
+    return err;
+}
+
+/* Read until the window has `want` complete arguments, the window is full,
+   or the stream ends. Arguments in the window are kept, moved to the front.
+
+[out] return: 0 if succeeded, <0 if error. The stream ends if error.
+              CARGV_IO_ERROR if read failed.
+              CARGV_NO_MEMORY if an argument is longer than the window.
+*/
+static int __stream_fill(struct cargv_t *cargv, _len want)
+{
+    _len rest, n;
+    char *end;
+
+    if (cargv->fd < 0 || cargv->eof || cargv->bufc >= want)
+        return CARGV_OK;
+
+    /* Move the rest to the front. */
+    rest = cargv->fillend - cargv->buf;
+    memmove(cargv->win, cargv->buf, (size_t)rest);
+    cargv->bufoff += cargv->buf - cargv->win;
+    cargv->bufend = cargv->win + (cargv->bufend - cargv->buf);
+    cargv->buf = cargv->win;
+    cargv->fillend = cargv->win + rest;
+
+    end = cargv->win + cargv->winsize;
+    while (cargv->bufc < want && !cargv->eof && cargv->fillend < end) {
+        n = (_len)_READ(cargv->fd, (char *)cargv->fillend,
+                        (size_t)(end - cargv->fillend));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            return __stream_fail(cargv, CARGV_IO_ERROR);
+        if (n == 0)
+            cargv->eof = 1;
+        cargv->fillend += n;
+        __stream_scan(cargv);
+    }
+    if (cargv->bufc == 0 && !cargv->eof)
+        return __stream_fail(cargv, CARGV_NO_MEMORY);  /* too long */
+    return CARGV_OK;
+}
+
+enum cargv_err_t
+cargv_init_fd(
+    struct cargv_t *cargv,
+    const char *name,
+    int fd, char delim,
+    char *win, cargv_len_t winsize)
+{
+    if (fd < 0 || !win || winsize <= 0)
+        return CARGV_BAD_PARAM;
+
+    cargv_init_lens(cargv, name, 0, NULL, NULL);
+    cargv->fd = fd;
+    cargv->delim = delim;
+    cargv->win = win;
+    cargv->winsize = winsize;
+    cargv->buf = cargv->bufend = cargv->fillend = cargv->bufbase = win;
+    cargv->eof = 0;
+    return (enum cargv_err_t)__stream_fill(cargv, 1);
+}
+
+/* @file expansion.
+
+Files are mapped read-only, and their arguments are slices of the mapping,
+kept in a table of arguments and lengths. Tables grow twice in the arena,
+leaving old ones behind.
+*/
+#define _EXPAND_PATH_MAX  4096
+
+static void *__expand_grow(
+    struct cargv_expand_t *exp, const void *old, _len n, _len cap, size_t size)
+{
+    void *p;
+
+    if ((size_t)cap > (size_t)-1 / size)
+        return NULL;
+    if ((p = cargv_arena_alloc(exp->arena, cap * (_len)size)) && n > 0)
+        memcpy(p, old, (size_t)n * size);
+    return p;
+}
+
+static int __expand_push(struct cargv_expand_t *exp, _str text, _len len)
+{
+    _len cap;
+    _str *args;
+    _len *lens;
+
+    if (exp->argc == exp->argcap) {
+        cap = exp->argcap ? exp->argcap * 2 : 64;
+        if (!(args = (_str *)__expand_grow(
+                exp, exp->args, exp->argc, cap, sizeof(*args))))
+            return CARGV_NO_MEMORY;
+        if (!(lens = (_len *)__expand_grow(
+                exp, exp->lens, exp->argc, cap, sizeof(*lens))))
+            return CARGV_NO_MEMORY;
+        exp->args = args;
+        exp->lens = lens;
+        exp->argcap = cap;
+    }
+    exp->args[exp->argc] = text;
+    exp->lens[exp->argc] = len;
+    ++exp->argc;
+    return CARGV_OK;
+}
+
+/* Map a file to memory, read only.
+
+[out] return: 0 if succeeded, <0 if error.
+[out] addr, len: Mapped memory. Null and 0 if the file is empty.
+[in]  path: Path of the file.
+*/
+static int __map_file(void **addr, size_t *len, const char *path)
+{
+    *addr = NULL;
+    *len = 0;
+
+#ifdef _WIN32
+    {
+        HANDLE f, m;
+        LARGE_INTEGER size;
+
+        f = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (f == INVALID_HANDLE_VALUE)
+            return CARGV_IO_ERROR;
+        if (!GetFileSizeEx(f, &size)) {
+            CloseHandle(f);
+            return CARGV_IO_ERROR;
+        }
+        *len = (size_t)size.QuadPart;
+        if (*len > 0) {
+            m = CreateFileMappingA(f, NULL, PAGE_READONLY, 0, 0, NULL);
+            *addr = m ? MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0) : NULL;
+            if (m)
+                CloseHandle(m);
+        }
+        CloseHandle(f);
+    }
+#else
+    {
+        int fd;
+        struct stat st;
+
+        if ((fd = open(path, O_RDONLY)) < 0)
+            return CARGV_IO_ERROR;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            return CARGV_IO_ERROR;
+        }
+        *len = (size_t)st.st_size;
+        if (*len > 0) {
+            *addr = mmap(NULL, *len, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (*addr == MAP_FAILED)
+                *addr = NULL;
+        }
+        close(fd);
+    }
+#endif
+
+    if (*len > 0 && !*addr)
+        return CARGV_IO_ERROR;
+    return CARGV_OK;
+}
+
+static void __unmap_file(void *addr, size_t len)
+{
+#ifdef _WIN32
+    (void)len;
+    UnmapViewOfFile(addr);
+#else
+    munmap(addr, len);
+#endif
+}
+
+/* Map a whole file read-only.
+
+[out] return: 0 if succeeded, <0 if error.
+[out] text, textend: Contents of the file. Empty if the file is empty.
+*/
+static int __expand_map(
+    struct cargv_expand_t *exp, _str *text, _str *textend, const char *path)
+{
+    struct cargv_expand_map_t *maps;
+    void *addr;
+    size_t len;
+    _len cap;
+    int r;
+
+    if (exp->mapc == exp->mapcap) {
+        cap = exp->mapcap ? exp->mapcap * 2 : 8;
+        if (!(maps = (struct cargv_expand_map_t *)__expand_grow(
+                exp, exp->maps, exp->mapc, cap, sizeof(*maps))))
+            return CARGV_NO_MEMORY;
+        exp->maps = maps;
+        exp->mapcap = cap;
+    }
+
+    if ((r = __map_file(&addr, &len, path)) < 0)
+        return r;
+    if (addr) {
+        exp->maps[exp->mapc].addr = addr;
+        exp->maps[exp->mapc].len = len;
+        ++exp->mapc;
+    }
+    *text = (_str)addr;
+    *textend = (_str)addr + len;
+    return CARGV_OK;
+}
+
+static int __expand_arg(
+    struct cargv_expand_t *exp, _str text, _len len, int level, int depth);
+
+/* Expand arguments of a file. */
+static int __expand_file(
+    struct cargv_expand_t *exp, _str path, _len pathlen, int level, int depth)
+{
+    char p[_EXPAND_PATH_MAX];
+    _str t, tend, a;
+    char q;
+    int r;
+
+    if (level >= depth)
+        return CARGV_NO_MEMORY;
+    if (pathlen >= (_len)sizeof(p))
+        return CARGV_IO_ERROR;
+    memcpy(p, path, (size_t)pathlen);
+    p[pathlen] = '\0';
+
+    if ((r = __expand_map(exp, &t, &tend, p)) < 0)
+        return r;
+
+    while (t < tend) {
+        if (__char_is(*t, _CC_SPACE)) {
+            ++t;
+            continue;
+        }
+        if (*t == '\'' || *t == '"') {
+            q = *t++;
+            a = t;
+            if ((t = __find_char(t, tend, q)) == tend)
+                return CARGV_BAD_PARAM;
+            if ((r = __expand_push(exp, a, t - a)) < 0)
+                return r;
+            ++t;
+            continue;
+        }
+        for (a = t; t < tend && !__char_is(*t, _CC_SPACE); ++t) {
+        }
+        if ((r = __expand_arg(exp, a, t - a, level+1, depth)) < 0)
+            return r;
+    }
+    return CARGV_OK;
+}
+
+static int __expand_arg(
+    struct cargv_expand_t *exp, _str text, _len len, int level, int depth)
+{
+    if (depth > 0 && len > 1 && text[0] == '@')
+        return __expand_file(exp, text+1, len-1, level, depth);
+    return __expand_push(exp, text, len);
+}
+
+enum cargv_err_t
+cargv_init_expand(
+    struct cargv_t *cargv,
+    const char *name,
+    int argc, const char **argv,
+    struct cargv_expand_t *exp,
+    int depth,
+    struct cargv_arena_t *arena)
+{
+    int i, r;
+
+    memset(exp, 0, sizeof(*exp));
+    if (arena) {
+        exp->arena = arena;
+    } else {
+        cargv_arena_init(&exp->own, NULL, 0, 0);
+        exp->arena = &exp->own;
+    }
+    for (i = 0; i < argc; ++i) {
+        if ((r = __expand_arg(
+                exp, argv[i], (_len)strlen(argv[i]), 0, depth)) < 0)
+            return (enum cargv_err_t)r;
+    }
+
+    cargv_init_lens(cargv, name, 0, argv, NULL);
+    cargv->args = exp->args;
+    cargv->argend = exp->args + exp->argc;
+    cargv->lens = exp->lens;
+    cargv->arena = arena;
+    return CARGV_OK;
+}
+
+void cargv_expand_release(struct cargv_expand_t *exp)
+{
+    _len i;
+
+    for (i = 0; i < exp->mapc; ++i)
+        __unmap_file(exp->maps[i].addr, exp->maps[i].len);
+    if (exp->arena == &exp->own)
+        cargv_arena_release(&exp->own);
+    memset(exp, 0, sizeof(*exp));
+}
+
+cargv_len_t cargv_len(const struct cargv_t *cargv)
+{
+    if (cargv->buf)
+        return cargv->bufc;
+    return cargv->argend - cargv->args;
+}
+
+cargv_len_t cargv_shift(struct cargv_t *cargv, cargv_len_t argc)
+{
+    _str b;
+    _len n;
+    int r;
+
+    if (cargv->fd >= 0) {
+        if (!(argc > 0))
+            return 0;
+
+        /* Read the arguments, and the next one if it fits, first. */
+        if ((r = __stream_fill(cargv, argc + 1)) < 0)
+            return r;
+        if (!(argc <= cargv->bufc))
+            return 0;
+        for (b = cargv->buf, n = 0; n < argc; ++n) {
+            b = __find_char(b, cargv->bufend, cargv->delim);
+            b = (b < cargv->bufend) ? b + 1 : cargv->bufend;
+        }
+        cargv->buf = b;
+        cargv->bufc -= argc;
+        cargv->argi += argc;
+        if ((r = __stream_fill(cargv, 1)) < 0)
+            return r;
+        return argc;
+    }
+    if (cargv->buf) {
+        if (!(argc > 0 && argc <= cargv->bufc))
+            return 0;
+        for (b = cargv->buf, n = 0; n < argc; ++n) {
+            b = __find_char(b, cargv->bufend, cargv->delim);
+            b = (b < cargv->bufend) ? b + 1 : cargv->bufend;
+        }
+        cargv->buf = b;
+        cargv->bufc -= argc;
+        cargv->argi += argc;
+        return argc;
+    }
+    if (argc > 0 && cargv->args + argc <= cargv->argend) {
+        cargv->args += argc;
+        if (cargv->lens)
+            cargv->lens += argc;
+        cargv->argi += argc;
+        return argc;
+    }
+    return 0;
+}
+
+cargv_len_t cargv_arg(struct cargv_t *cargv, const char **arg)
+{
+    _cursor cur;
+    _str a, aend;
+
+    __cursor_init(&cur, cargv);
+    if (!__cursor_get(&cur, &a, &aend))
+        return -1;
+    *arg = a;
+    return aend - a;
+}
+
+/* Split an option list into short options and long options.
+
+[out] lopt: Points the start of long options, `--`. `oend` if none.
+[out] shorts, shortend: Short option characters, without `-`.
+                        Empty if none.
+[in]  optlist, oend: An option list.
+*/
+static void __optlist_split(
+    _str *lopt, _str *shorts, _str *shortend,
+    _str optlist, _str oend)
+{
+    _str o;
+
+    __unmatch_str(lopt, optlist, oend, "--", 2);
+    o = optlist;
+    if (__match_str(&o, o, *lopt, "-", 1))
+        *shorts = o;
+    else
+        *shorts = *lopt;
+    *shortend = *lopt;
+}
+
+/* Get the next long option name from long options.
+
+[out] return: 1 if found, 0 if ran out.
+[in/out] o: Points `--` of the next long option. Moves to the one after.
+[out] name, nameend: Long option name, without `--`.
+[in]  oend: End of the option list.
+*/
+static int __optlist_next_long(_str *o, _str *name, _str *nameend, _str oend)
+{
+    if (!(*o < oend))
+        return 0;
+    *name = *o + 2;   /* already matched */
+    __unmatch_str(nameend, *name, oend, "--", 2);
+    *o = *nameend;
+    return 1;
+}
+
+/* Hash of a long option name, from its length and a few characters. */
+static unsigned __opt_hash(_str name, _len len)
+{
+    unsigned h = (unsigned)len;
+
+    if (len > 0) {
+        h = h * 31 + (unsigned char)name[0];
+        h = h * 31 + (unsigned char)name[len-1];
+    }
+    if (len > 2)
+        h = h * 31 + (unsigned char)name[1];
+    return h ^ (h >> 7);
+}
+
+#define _OPTSET_SLOT_MASK   (CARGV_OPTSET_SLOTS - 1)
+
+enum cargv_err_t cargv_optset_init(
+    struct cargv_optset_t *optset,
+    const char *optlist)
+{
+    _str oend, o, lopt, shorts, shortend, name, nameend;
+    unsigned h;
+
+    memset(optset, 0, sizeof(*optset));
+    oend = optlist + strlen(optlist);
+
+    /* Short option of `*`, `-*`, matches any option */
+    o = optlist;
+    optset->wildcard = __match_str(&o, o, oend, "-", 1)
+                       && __match_str(&o, o, oend, "*", 1)
+                       && __match_end(o, oend);
+
+    __optlist_split(&lopt, &shorts, &shortend, optlist, oend);
+
+    /* Short options */
+    optset->shortc = shortend - shorts;
+    for (o = shorts; o < shortend; ++o)
+        optset->shorts[(unsigned char)*o >> 5] |=
+            1u << ((unsigned char)*o & 31);
+
+    /* Long options */
+    o = lopt;
+    while (__optlist_next_long(&o, &name, &nameend, oend)) {
+        if (!(nameend > name))
+            continue;   /* `--` never matches */
+        if (!(optset->longc < CARGV_OPTSET_LONG_MAX))
+            return CARGV_NO_MEMORY;
+
+        h = __opt_hash(name, nameend - name);
+        while (optset->slots[h & _OPTSET_SLOT_MASK])
+            ++h;
+        optset->slots[h & _OPTSET_SLOT_MASK] =
+            (unsigned char)(optset->longc + 1);
+        optset->longs[optset->longc] = name;
+        optset->longlens[optset->longc] = nameend - name;
+        ++optset->longc;
+    }
+    return CARGV_OK;
+}
+
+/* See if a text is a long option name in a compiled option list. */
+static int __optset_long(
+    const struct cargv_optset_t *optset, _str text, _str textend)
+{
+    _len len = textend - text;
+    unsigned h = __opt_hash(text, len);
+    int i;
+
+    while ((i = optset->slots[h & _OPTSET_SLOT_MASK]) != 0) {
+        --i;
+        if (optset->longlens[i] == len
+            && memcmp(optset->longs[i], text, (size_t)len) == 0)
+            return 1;
+        ++h;
+    }
+    return 0;
+}
+
+/* See if a text is made of short options in a compiled option list. */
+static int __optset_short(
+    const struct cargv_optset_t *optset, _str text, _str textend)
+{
+    _str t;
+
+    if (!(textend - text <= optset->shortc))
+        return 0;
+    for (t = text; t < textend; ++t) {
+        if (!(optset->shorts[(unsigned char)*t >> 5]
+              & (1u << ((unsigned char)*t & 31))))
+            return 0;
+    }
+    return 1;
+}
+
+int cargv_optset(
+    struct cargv_t *cargv,
+    const struct cargv_optset_t *optset)
+{
+    _cursor cur;
+    _str aend, a;
+
+    __cursor_init(&cur, cargv);
+    if (!__cursor_get(&cur, &a, &aend))
+        return 0;
+
+    /* Argument is long option, like `--long-option` */
+    if (__match_str(&a, a, aend, "--", 2)) {
+        if (__match_end(a, aend))
+            return 0;   /* -- */
+        return optset->wildcard || __optset_long(optset, a, aend);
+    }
+    /* Argument is short option, like `-s` */
+    else if (__match_str(&a, a, aend, "-", 1)) {
+        if (__match_end(a, aend))
+            return 0;   /* - */
+        return optset->wildcard || __optset_short(optset, a, aend);
+    }
+    return 0;
+}
+
+int cargv_opt(struct cargv_t *cargv, const char *optlist)
+{
+    _cursor cur;
+    _str oend, o, lopt, shorts, shortend, name, nameend;
+    _str aend, a;
+    int wildcard;
+
+    __cursor_init(&cur, cargv);
+    if (!__cursor_get(&cur, &a, &aend))
+        return 0;
+    oend = optlist + strlen(optlist);
+
+    /* Short option of `*`, `-*`, matches any option */
+    o = optlist;
+    wildcard = __match_str(&o, o, oend, "-", 1)
+               && __match_str(&o, o, oend, "*", 1)
+               && __match_end(o, oend);
+
+    __optlist_split(&lopt, &shorts, &shortend, optlist, oend);
+
+    /* Argument is long option, like `--long-option` */
+    if (__match_str(&a, a, aend, "--", 2)) {
+        if (__match_end(a, aend))
+            return 0;   /* -- */
+        if (wildcard)
+            return 1;
+
+        /* Iterate long options */
+        o = lopt;
+        while (__optlist_next_long(&o, &name, &nameend, oend)) {
+            if (nameend - name == aend - a
+                && memcmp(name, a, (size_t)(aend - a)) == 0)
+                return 1;
+        }
+    }
+    /* Argument is short option, like `-s` */
+    else if (__match_str(&a, a, aend, "-", 1)) {
+        if (__match_end(a, aend))
+            return 0;   /* - */
+        if (wildcard)
+            return 1;
+
+        /* Find in short options */
+        if (!(aend - a <= shortend - shorts))
+            return 0;
+        for (; a < aend; ++a)
+            if (!memchr(shorts, *a, (size_t)(shortend - shorts)))
+                return 0;
+        return 1;
+    }
+    return 0;
+}
+
+cargv_len_t cargv_text(
+    struct cargv_t *cargv,
+    const char *name,
+    const char **vals, cargv_len_t valc)
+{
+    _cursor cur;
+    _str *v, t, e;
+    (void)name;
+
+    __cursor_init(&cur, cargv);
+    v = vals;
+    while (v - vals < valc && __cursor_get(&cur, &t, &e)) {
+        *v++ = t;
+        __cursor_next(&cur);
+    }
+    return v-vals;
+}
+
+cargv_len_t cargv_oneof(
+    struct cargv_t *cargv,
+    const char *name,
+    const char *list, const char *sep,
+    const char **vals, cargv_len_t valc)
+{
+    _cursor cur;
+    _str *val;
+    _str listend, t, tend;
+    _str aend, a, arg;
+    _len seplen;
+    (void)name;
+
+    listend = list + strlen(list);
+    seplen = (_len)strlen(sep);
+
+    __cursor_init(&cur, cargv);
+    val = vals;
+    while (val - vals < valc && __cursor_get(&cur, &arg, &aend)) {
+        a = arg;
+        t = list;
+        while (t < listend) {
+            __unmatch_str(&tend, t, listend, sep, seplen);
+            if (__match_str(&a, a, aend, t, tend-t) && __match_end(a, aend))
+                break;
+            t = tend + seplen;
+        }
+        if (t < listend)    /* found */
+            *val++ = arg;
+        else
+            break;
+        __cursor_next(&cur);
+    }
+    return val-vals;
+}
+
+/* Hash of a choice text, FNV-1a. */
+static uint32_t __choice_hash(_str text, _len len)
+{
+    uint32_t h = 2166136261u;
+    _len i;
+
+    for (i = 0; i < len; ++i)
+        h = (h ^ (unsigned char)text[i]) * 16777619u;
+    return h;
+}
+
+/* Find a text in a compiled list.
+
+[out] return: Index of the choice, or -1 if not found.
+*/
+static _len __choiceset_find(
+    const struct cargv_choiceset_t *set, _str text, _len len)
+{
+    uint32_t h = __choice_hash(text, len);
+    _len s, i;
+
+    for (s = (_len)h & set->slotmask;
+         (i = set->slots[s]) != 0;
+         s = (s+1) & set->slotmask) {
+        --i;
+        if (set->hashes[i] == h && set->lens[i] == len
+            && memcmp(set->texts[i], text, (size_t)len) == 0)
+            return i;
+    }
+    return -1;
+}
+
+enum cargv_err_t cargv_choiceset_init(
+    struct cargv_choiceset_t *set,
+    const char *list, const char *sep,
+    struct cargv_arena_t *arena)
+{
+    _str listend, t, tend;
+    _len seplen, n, slotc, s;
+    int found;
+
+    memset(set, 0, sizeof(*set));
+    listend = list + strlen(list);
+    if ((seplen = (_len)strlen(sep)) == 0)
+        return CARGV_BAD_PARAM;
+
+    /* Count choices, at least 1 for an empty table */
+    n = 1;
+    for (t = list; t < listend; t = tend + seplen) {
+        __unmatch_str(&tend, t, listend, sep, seplen);
+        ++n;
+    }
+    /* Twice as many slots as choices, at most half full */
+    for (slotc = 2; slotc < n * 2; slotc *= 2) {
+    }
+
+    set->texts = (_str *)cargv_arena_alloc(arena, n * (_len)sizeof(_str));
+    set->lens = (_len *)cargv_arena_alloc(arena, n * (_len)sizeof(_len));
+    set->hashes = (uint32_t *)cargv_arena_alloc(
+        arena, n * (_len)sizeof(uint32_t));
+    set->slots = (_len *)cargv_arena_alloc(arena, slotc * (_len)sizeof(_len));
+    if (!set->texts || !set->lens || !set->hashes || !set->slots)
+        return CARGV_NO_MEMORY;
+    memset(set->slots, 0, (size_t)slotc * sizeof(_len));
+    set->slotmask = slotc - 1;
+
+    for (t = list; t < listend; t = tend + seplen) {
+        __unmatch_str(&tend, t, listend, sep, seplen);
+        found = __choiceset_find(set, t, tend-t) >= 0;
+        n = set->count++;
+        set->texts[n] = t;
+        set->lens[n] = tend-t;
+        set->hashes[n] = __choice_hash(t, tend-t);
+        if (found || tend == t)
+            continue;   /* first one is taken, and empty never matches */
+        for (s = (_len)set->hashes[n] & set->slotmask;
+             set->slots[s] != 0;
+             s = (s+1) & set->slotmask) {
+        }
+        set->slots[s] = n+1;
+    }
+    return CARGV_OK;
+}
+
+cargv_len_t cargv_choice(
+    struct cargv_t *cargv,
+    const char *name,
+    const struct cargv_choiceset_t *set,
+    cargv_len_t *vals, cargv_len_t valc)
+{
+    _cursor cur;
+    _len *v, i;
+    _str a, aend;
+    (void)name;
+
+    __cursor_init(&cur, cargv);
+    v = vals;
+    while (v - vals < valc && __cursor_get(&cur, &a, &aend)) {
+        if ((i = __choiceset_find(set, a, aend-a)) < 0)
+            break;
+        *v++ = i;
+        __cursor_next(&cur);
+    }
+    return v-vals;
+}
+
+cargv_len_t cargv_int(
+    struct cargv_t *cargv,
+    const char *name,
+    cargv_int_t *vals, cargv_len_t valc)
+{
+    int r;
+    _cursor cur;
+    _sint *v, n;
+    _str a, t, e;
+
+    __cursor_init(&cur, cargv);
+    v = vals;
+    while (v - vals < valc && __cursor_get(&cur, &a, &e)) {
+        if ((r = __read_sint_dec(&n, &t, a, e)) == 0)
+            break;
+        if (!__match_end(t, e))
+            break;
+        if (r < 0)
+            return err_val_result(cargv, name, "integer", cur.i, a, e, r);
+
+        *v++ = n;
+        __cursor_next(&cur);
+    }
+    return v-vals;
+}
+
+cargv_len_t cargv_uint(
+    struct cargv_t *cargv,
+    const char *name,
+    cargv_uint_t *vals, cargv_len_t valc)
+{
+    int r;
+    _cursor cur;
+    _uint *v, n;
+    _str a, t, e;
+
+    __cursor_init(&cur, cargv);
+    v = vals;
+    while (v - vals < valc && __cursor_get(&cur, &a, &e)) {
+        if ((r = __read_uint_dec(&n, &t, a, e)) == 0)
+            break;
+        if (!__match_end(t, e))
+            break;
+        if (r < 0)
+            return err_val_result(
+                cargv, name, "unsigned integer", cur.i, a, e, r);
+
+        *v++ = n;
+        __cursor_next(&cur);
+    }
+    return v-vals;
+}
+
+cargv_len_t cargv_real(
+    struct cargv_t *cargv,
+    const char *name,
+    cargv_real_t *vals, cargv_len_t valc)
+{
+    int r;
+    _cursor cur;
+    _real *v, n;
+    _str a, t, e;
+
+    __cursor_init(&cur, cargv);
+    v = vals;
+    while (v - vals < valc && __cursor_get(&cur, &a, &e)) {
+        if ((r = __read_real_dec(&n, &t, a, e)) == 0)
+            break;
+        if (!__match_end(t, e))
+            break;
+        if (r < 0)
+            return err_val_result(cargv, name, "real number", cur.i, a, e, r);
+
+        *v++ = n;
+        __cursor_next(&cur);
+    }
+    return v-vals;
+}
+
+cargv_len_t cargv_date(
+    struct cargv_t *cargv,
+    const char *name,
+    struct cargv_datetime_t *vals, cargv_len_t valc)
+{
+    return cargv_date_format(cargv, name, CARGV_FORMAT_ANY, vals, valc);
+}
+
+cargv_len_t cargv_time(
+    struct cargv_t *cargv,
+    const char *name,
+    struct cargv_datetime_t *vals, cargv_len_t valc)
+{
+    return cargv_time_format(cargv, name, CARGV_FORMAT_ANY, vals, valc);
+}
+
+cargv_len_t cargv_datetime(
+    struct cargv_t *cargv,
+    const char *name,
+    struct cargv_datetime_t *vals, cargv_len_t valc)
+{
+    return cargv_datetime_format(cargv, name, CARGV_FORMAT_ANY, vals, valc);
+}
+
+static int __zoned_datetime(
+    struct cargv_t *cargv, int format, int parts,
+    const struct cargv_zone_t **last,
+    _ymd *d, _hms *h, _tz *tz, _str text, _str textend);
+static int __arg_timezone_zone(_tz *tz, _str text, _str textend);
+
+cargv_len_t cargv_date_format(
+    struct cargv_t *cargv,
+    const char *name,
+    enum cargv_datetime_format_t format,
+    struct cargv_datetime_t *vals, cargv_len_t valc)
+{
+    int r;
+    _cursor cur;
+    _datetime *v;
+    _ymd d;
+    _hms h;
+    _tz tz;
+    _str a, e;
+
+    __cursor_init(&cur, cargv);
+    v = vals;
+    while (v - vals < valc && __cursor_get(&cur, &a, &e)) {
+        if ((r = __predict_datetime(cargv, format, _FMT_DATE,
+                                    &d, &h, &tz, a, e)) == 0)
+            break;
+        if (r < 0)
+            return err_val_result(cargv, name, "date", cur.i, a, e, r);
+
+        v->year = d.year;
+        v->month = d.month;
+        v->day = d.day;
+        v->hour = _h_DEFAULT;
+        v->minute = _m_DEFAULT;
+        v->second = _s_DEFAULT;
+        v->milisecond = _ms_DEFAULT;
+        v->tz.hour = _TZh_DEFAULT;
+        v->tz.minute = _TZm_DEFAULT;
+        ++v;
+        __cursor_next(&cur);
+    }
+    return v-vals;
+}
+
+cargv_len_t cargv_time_format(
+    struct cargv_t *cargv,
+    const char *name,
+    enum cargv_datetime_format_t format,
+    struct cargv_datetime_t *vals, cargv_len_t valc)
+{
+    int r;
+    _cursor cur;
+    _datetime *v;
+    _ymd d;
+    _hms h;
+    _tz tz;
+    _str a, e;
+    const struct cargv_zone_t *last = NULL;
+
+    __cursor_init(&cur, cargv);
+    v = vals;
+    while (v - vals < valc && __cursor_get(&cur, &a, &e)) {
+        if ((r = __zoned_datetime(cargv, format, _FMT_TIME,
+                                  &last, &d, &h, &tz, a, e)) == 0)
+            break;
+        if (r < 0)
+            return err_val_result(cargv, name, "time", cur.i, a, e, r);
+
+        v->year = _Y_DEFAULT;
+        v->month = _M_DEFAULT;
+        v->day = _D_DEFAULT;
+        v->hour = h.hour;
+        v->minute = h.minute;
+        v->second = h.second;
+        v->milisecond = h.milisecond;
+        memcpy(&v->tz, &tz, sizeof(v->tz));
+        ++v;
+        __cursor_next(&cur);
+    }
+    return v-vals;
+}
+
+cargv_len_t cargv_timezone(
+    struct cargv_t *cargv,
+    const char *name,
+    struct cargv_timezone_t *vals, cargv_len_t valc)
+{
+    int r;
+    _cursor cur;
+    _tz *v, z;
+    _str a, e;
+
+    __cursor_init(&cur, cargv);
+    v = vals;
+    while (v - vals < valc && __cursor_get(&cur, &a, &e)) {
+        if ((r = __arg_timezone(&z, a, e)) == 0
+            && (r = __arg_timezone_zone(&z, a, e)) == 0)
+            break;
+        if (r < 0)
+            return err_val_result(cargv, name, "timezone", cur.i, a, e, r);
+
+        memcpy(v++, &z, sizeof(*v));
+        __cursor_next(&cur);
+    }
+    return v-vals;
+}
+
+cargv_len_t cargv_datetime_format(
+    struct cargv_t *cargv,
+    const char *name,
+    enum cargv_datetime_format_t format,
+    struct cargv_datetime_t *vals, cargv_len_t valc)
+{
+    int r;
+    _cursor cur;
+    _datetime *v;
+    _ymd d;
+    _hms h;
+    _tz tz;
+    _str a, e;
+    const struct cargv_zone_t *last = NULL;
+
+    __cursor_init(&cur, cargv);
+    v = vals;
+    while (v - vals < valc && __cursor_get(&cur, &a, &e)) {
+        if ((r = __zoned_datetime(cargv, format, _FMT_DATE|_FMT_TIME,
+                                  &last, &d, &h, &tz, a, e)) == 0)
+            break;
+        if (r < 0)
+            return err_val_result(cargv, name, "datetime", cur.i, a, e, r);
+
+        v->year = d.year;
+        v->month = d.month;
+        v->day = d.day;
+        v->hour = h.hour;
+        v->minute = h.minute;
+        v->second = h.second;
+        v->milisecond = h.milisecond;
+        memcpy(&v->tz, &tz, sizeof(v->tz));
+
+        ++v;
+        __cursor_next(&cur);
+    }
+    return v-vals;
+}
+
+/* Pack a read datetime. Omitted members are in default values. */
+static void __pack_datetime(
+    _dtpack *p, const _ymd *d, const _hms *h, const _tz *tz)
+{
+    p->present = (uint8_t)(
+        (d->year != _Y_DEFAULT ? CARGV_HAS_YEAR : 0)
+        | (d->month != _M_DEFAULT ? CARGV_HAS_MONTH : 0)
+        | (d->day != _D_DEFAULT ? CARGV_HAS_DAY : 0)
+        | (h->hour != _h_DEFAULT ? CARGV_HAS_HOUR : 0)
+        | (h->minute != _m_DEFAULT ? CARGV_HAS_MINUTE : 0)
+        | (h->second != _s_DEFAULT ? CARGV_HAS_SECOND : 0)
+        | (h->milisecond != _ms_DEFAULT ? CARGV_HAS_MILISECOND : 0)
+        | (tz->hour != _TZh_DEFAULT ? CARGV_HAS_TZ : 0));
+
+    p->year = (int16_t)((p->present & CARGV_HAS_YEAR) ? d->year : 0);
+    p->month = (uint8_t)d->month;
+    p->day = (uint8_t)d->day;
+    p->hour = (uint8_t)((p->present & CARGV_HAS_HOUR) ? h->hour : 0);
+    p->minute = (uint8_t)((p->present & CARGV_HAS_MINUTE) ? h->minute : 0);
+    p->second = (uint8_t)((p->present & CARGV_HAS_SECOND) ? h->second : 0);
+    p->milisecond = (uint16_t)(
+        (p->present & CARGV_HAS_MILISECOND) ? h->milisecond : 0);
+    p->tz_hour = (int8_t)((p->present & CARGV_HAS_TZ) ? tz->hour : 0);
+    p->tz_minute = (int8_t)((p->present & CARGV_HAS_TZ) ? tz->minute : 0);
+}
+
+cargv_len_t cargv_date_packed(
+    struct cargv_t *cargv,
+    const char *name,
+    struct cargv_datetime_packed_t *vals, cargv_len_t valc)
+{
+    int r;
+    _cursor cur;
+    _dtpack *v;
+    _ymd d;
+    _str a, e;
+
+    __cursor_init(&cur, cargv);
+    v = vals;
+    while (v - vals < valc && __cursor_get(&cur, &a, &e)) {
+        if ((r = __arg_date(&d, a, e)) == 0)
+            break;
+        if (r < 0)
+            return err_val_result(cargv, name, "date", cur.i, a, e, r);
+
+        __pack_datetime(v++, &d, &_HMS_DEFAULT, &_TZ_DEFAULT);
+        __cursor_next(&cur);
+    }
+    return v-vals;
+}
+
+cargv_len_t cargv_time_packed(
+    struct cargv_t *cargv,
+    const char *name,
+    struct cargv_datetime_packed_t *vals, cargv_len_t valc)
+{
+    int r;
+    _cursor cur;
+    _dtpack *v;
+    _ymd d;
+    _hms h;
+    _tz tz;
+    _str a, e;
+    const struct cargv_zone_t *last = NULL;
+
+    __cursor_init(&cur, cargv);
+    v = vals;
+    while (v - vals < valc && __cursor_get(&cur, &a, &e)) {
+        if ((r = __zoned_datetime(NULL, CARGV_FORMAT_ANY, _FMT_TIME,
+                                  &last, &d, &h, &tz, a, e)) == 0)
+            break;
+        if (r < 0)
+            return err_val_result(cargv, name, "time", cur.i, a, e, r);
+
+        __pack_datetime(v++, &_YMD_DEFAULT, &h, &tz);
+        __cursor_next(&cur);
+    }
+    return v-vals;
+}
+
+cargv_len_t cargv_datetime_packed(
+    struct cargv_t *cargv,
+    const char *name,
+    struct cargv_datetime_packed_t *vals, cargv_len_t valc)
+{
+    int r;
+    _cursor cur;
+    _dtpack *v;
+    _ymd d;
+    _hms h;
+    _tz tz;
+    _str a, e;
+    const struct cargv_zone_t *last = NULL;
+
+    __cursor_init(&cur, cargv);
+    v = vals;
+    while (v - vals < valc && __cursor_get(&cur, &a, &e)) {
+        if ((r = __zoned_datetime(NULL, CARGV_FORMAT_ANY, _FMT_DATE|_FMT_TIME,
+                                  &last, &d, &h, &tz, a, e)) == 0)
+            break;
+        if (r < 0)
+            return err_val_result(cargv, name, "datetime", cur.i, a, e, r);
+
+        __pack_datetime(v++, &d, &h, &tz);
+        __cursor_next(&cur);
+    }
+    return v-vals;
+}
+
+void cargv_unpack_datetime(
+    struct cargv_datetime_t *dst,
+    const struct cargv_datetime_packed_t *src)
+{
+    dst->year = (src->present & CARGV_HAS_YEAR) ? src->year : _Y_DEFAULT;
+    dst->month = (src->present & CARGV_HAS_MONTH) ? src->month : _M_DEFAULT;
+    dst->day = (src->present & CARGV_HAS_DAY) ? src->day : _D_DEFAULT;
+    dst->hour = (src->present & CARGV_HAS_HOUR) ? src->hour : _h_DEFAULT;
+    dst->minute =
+        (src->present & CARGV_HAS_MINUTE) ? src->minute : _m_DEFAULT;
+    dst->second =
+        (src->present & CARGV_HAS_SECOND) ? src->second : _s_DEFAULT;
+    dst->milisecond =
+        (src->present & CARGV_HAS_MILISECOND) ? src->milisecond : _ms_DEFAULT;
+    if (src->present & CARGV_HAS_TZ) {
+        dst->tz.hour = src->tz_hour;
+        dst->tz.minute = src->tz_minute;
+    }
+    else
+        memcpy(&dst->tz, &_TZ_DEFAULT, sizeof(dst->tz));
+}
+
+/* Epoch time.
+
+Days are counted from the civil date and back with Howard Hinnant's
+days_from_civil algorithm. Years are shifted by _EPOCH_Y_SHIFT, a multiple
+of 400, so that every intermediate stays non-negative within
+-9999..9999, and month shifts use arithmetic instead of branches.
+Omitted and invalid members are masked instead of branched on, so the
+array versions compile into straight loops.
+*/
+#define _EPOCH_Y_SHIFT    10000
+#define _EPOCH_DAY_SHIFT  (719468 + _EPOCH_Y_SHIFT / 400 * 146097)
+#define _EPOCH_BLOCK      64
+
+static const _sint _EPOCH_SCALE[] = {
+    1, 1000, 1000000, 1000000000,
+};
+
+/* Floor division */
+static _sint __floor_div(_sint a, _sint b)
+{
+    return a / b - (a % b < 0);
+}
+
+static _sint __days_from_civil(_sint y, _sint m, _sint d)
+{
+    _sint era, yoe, mp, doy, doe;
+
+    y += _EPOCH_Y_SHIFT - (m <= 2);
+    era = y / 400;
+    yoe = y - era * 400;
+    mp = m + 9 - 12 * (m > 2);     /* March is 0 */
+    doy = (153 * mp + 2) / 5 + d - 1;
+    doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - _EPOCH_DAY_SHIFT;
+}
+
+static void __civil_from_days(_sint *y, _sint *m, _sint *d, _sint days)
+{
+    _sint era, doe, yoe, doy, mp;
+
+    days += _EPOCH_DAY_SHIFT;
+    era = days / 146097;
+    doe = days - era * 146097;
+    yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    mp = (5 * doy + 2) / 153;
+    *d = doy - (153 * mp + 2) / 5 + 1;
+    *m = mp + 3 - 12 * (mp >= 10);
+    *y = yoe + era * 400 + (*m <= 2) - _EPOCH_Y_SHIFT;
+}
+
+/* Convert one datetime. See cargv_datetime_to_epoch().
+
+[in] scale: Epoch units in a second, one of _EPOCH_SCALE.
+*/
+static int __datetime_to_epoch(_sint *epoch, const _datetime *v, _sint scale)
+{
+    _sint y, m, d, h, mi, s, ms, tzh, tzm, sec, lim, ok;
+    int omit, bad;
+
+    omit = (v->year == _Y_DEFAULT)
+           | (v->tz.hour == _TZh_DEFAULT) | (v->tz.minute == _TZm_DEFAULT);
+
+    /* Omitted members to their first value */
+    m = v->month + (v->month == _M_DEFAULT);
+    d = v->day + (v->day == _D_DEFAULT);
+    h = v->hour & -(_sint)(v->hour != _h_DEFAULT);
+    mi = v->minute & -(_sint)(v->minute != _m_DEFAULT);
+    s = v->second & -(_sint)(v->second != _s_DEFAULT);
+    ms = v->milisecond & -(_sint)(v->milisecond != _ms_DEFAULT);
+
+    bad = (v->year < _Y_MIN) | (v->year > _Y_MAX)
+          | (m < 1) | (m > 12) | (d < 1) | (d > 31)
+          | (h < 0) | (h > 24) | (mi < 0) | (mi > 59)
+          | (s < 0) | (s > 59) | (ms < 0) | (ms > 999)
+          | ((h == 24) & ((mi | s | ms) != 0))
+          | (v->tz.hour < _TZh_MIN) | (v->tz.hour > _TZh_MAX)
+          | (v->tz.minute < -59) | (v->tz.minute > 59);
+
+    /* Zero everything if bad, not to overflow below. */
+    ok = -(_sint)!(bad | omit);
+    y = v->year & ok;
+    m = (m & ok) | (1 & ~ok);
+    d = (d & ok) | (1 & ~ok);
+    bad |= d > __days_of_month(y, (_uint)m);
+
+    ok = -(_sint)!(bad | omit);
+    tzh = v->tz.hour & ok;
+    tzm = v->tz.minute & ok;
+    sec = __days_from_civil(y, m, d) * 86400
+          + (h & ok) * 3600 + (mi & ok) * 60 + (s & ok)
+          - (tzh * 3600 + tzm * 60);
+
+    /* Fits in cargv_int_t with milliseconds? */
+    lim = _SINT_MAX / scale - 1;
+    bad |= (sec > lim) | (sec < -lim);
+    ok = -(_sint)!(bad | omit);
+
+    *epoch = (sec & ok) * scale + (ms & ok) * scale / 1000;
+    return omit ? CARGV_BAD_PARAM : bad ? CARGV_VAL_OVERFLOW : CARGV_OK;
+}
+
+/* Convert one epoch time but the date. See __epoch_to_datetime().
+
+[out] days: Days from 1970-01-01 of the date, 0 if error.
+*/
+static int __epoch_to_time(
+    _datetime *dst, _sint *days, _sint epoch, _sint scale, const _tz *tz)
+{
+    _sint sec, sub, tod, dmin, dmax;
+    int bad;
+
+    /* Floor division by scale, and by a day */
+    sec = epoch / scale;
+    sub = epoch % scale;
+    sec -= (sub < 0);
+    sub += scale & -(_sint)(sub < 0);
+
+    dmin = __days_from_civil(_Y_MIN, 1, 1);
+    dmax = __days_from_civil(_Y_MAX, 12, 31);
+    bad = (sec < (dmin - 1) * 86400) | (sec > (dmax + 1) * 86400);
+    sec = (sec & -(_sint)!bad) + tz->hour * 3600 + tz->minute * 60;
+
+    *days = sec / 86400;
+    tod = sec % 86400;
+    *days -= (tod < 0);
+    tod += 86400 & -(_sint)(tod < 0);
+
+    bad |= (*days < dmin) | (*days > dmax);
+    *days &= -(_sint)!bad;
+
+    dst->hour = tod / 3600;
+    dst->minute = tod / 60 % 60;
+    dst->second = tod % 60;
+    dst->milisecond = sub * 1000 / scale;
+    dst->tz.hour = tz->hour;
+    dst->tz.minute = tz->minute;
+    return bad ? CARGV_VAL_OVERFLOW : CARGV_OK;
+}
+
+/* Convert one epoch time. See cargv_epoch_to_datetime().
+
+[in] scale: Epoch units in a second, one of _EPOCH_SCALE.
+[in] tz: Time zone, not omitted.
+*/
+static int __epoch_to_datetime(
+    _datetime *dst, _sint epoch, _sint scale, const _tz *tz)
+{
+    _sint days;
+    int r;
+
+    r = __epoch_to_time(dst, &days, epoch, scale, tz);
+    __civil_from_days(&dst->year, &dst->month, &dst->day, days);
+    return r;
+}
+
+/* See if a time zone is omitted, the local time zone. */
+static int __tz_local(const _tz *tz)
+{
+    return tz->hour == _TZh_DEFAULT || tz->minute == _TZm_DEFAULT;
+}
+
+/* Check the time zone of epoch conversions.
+
+[out] return: 0 if a fixed offset, 1 if the local time zone, <0 if error.
+*/
+static int __epoch_tz(const _tz **tz)
+{
+    if (*tz == NULL)
+        *tz = &_TZ_0;
+    if (__tz_local(*tz))
+        return 1;
+    if ((*tz)->hour < _TZh_MIN || (*tz)->hour > _TZh_MAX
+        || (*tz)->minute < -59 || (*tz)->minute > 59)
+        return CARGV_VAL_OVERFLOW;
+    return CARGV_OK;
+}
+
+/* Datetimes between fixed time zones.
+
+A datetime is loaded as a date and minutes of the day, shifted by the
+difference of the time zones, and stored back. Whole days of the shift are
+carried through the day count of __days_from_civil(), so that any number
+of days rolls over months and years. Seconds and milliseconds are left as
+they are, as time zones are whole minutes.
+
+Arrays are shifted by columns of unsigned 32-bit members, _EPOCH_BLOCK at
+a time, with the same arithmetic on values made non-negative by
+_LOCAL_Y_SHIFT and _LOCAL_MIN_SHIFT, so that the loop compiles without
+branches into vector code. Epoch times take the second half of it, dates
+of days. Kernels for AVX2 are picked at run time if the CPU has it.
+*/
+#define _LOCAL_Y_SHIFT    (_EPOCH_Y_SHIFT + 400)
+#define _LOCAL_DAY_SHIFT  (_EPOCH_DAY_SHIFT + 146097)
+#define _LOCAL_MIN_SHIFT  (2 * 1440)
+#define _LOCAL_Y_NONE     2000  /* leap year for dates without the year */
+
+#if defined(__GNUC__)
+  #define _ALWAYS_INLINE  __inline__ __attribute__((always_inline))
+#else
+  #define _ALWAYS_INLINE
+#endif
+
+typedef struct _civil_cols {
+    uint32_t y[_EPOCH_BLOCK];   /* Years, by _LOCAL_Y_SHIFT */
+    uint32_t m[_EPOCH_BLOCK];
+    uint32_t d[_EPOCH_BLOCK];
+    uint32_t min[_EPOCH_BLOCK]; /* Minutes of the day, by _LOCAL_MIN_SHIFT */
+} _civil_cols;
+
+/* Kernels of columns, in place.
+
+shift:     Shift loaded datetimes into their days. See __local_load().
+from_days: Dates of days in `d`, from 1970-01-01 by _LOCAL_DAY_SHIFT.
+*/
+typedef void f_civil_cols(_civil_cols *cols);
+
+struct _civil_kernel_t {
+    f_civil_cols *shift;
+    f_civil_cols *from_days;
+};
+
+/* Load a datetime to shift to the time zone `tz`.
+
+Omitted hour and minute are 0. Dates without the year are taken in a leap
+year. Time zones should not be omitted.
+
+[out] return: 0 if succeeded, <0 if error.
+[out] y, m, d, min: Date, and minutes of the day in `tz`, which may be out
+                    of the day. 0001-01-01T00:00 if error.
+*/
+static int __local_load(
+    _sint *y, _sint *m, _sint *d, _sint *min,
+    const _datetime *src, const _tz *tz)
+{
+    _sint yy, mm, dd, h, mi, s, ms, ok;
+    int date, bad;
+
+    date = src->day != _D_DEFAULT;
+    yy = (src->year == _Y_DEFAULT) ? _LOCAL_Y_NONE : src->year;
+    mm = date ? src->month : 1;
+    dd = date ? src->day : 1;
+    h = src->hour & -(_sint)(src->hour != _h_DEFAULT);
+    mi = src->minute & -(_sint)(src->minute != _m_DEFAULT);
+    s = src->second & -(_sint)(src->second != _s_DEFAULT);
+    ms = src->milisecond & -(_sint)(src->milisecond != _ms_DEFAULT);
+
+    bad = (yy < _Y_MIN) | (yy > _Y_MAX)
+          | (mm < 1) | (mm > 12) | (dd < 1) | (dd > 31)
+          | (h < 0) | (h > 24) | (mi < 0) | (mi > 59)
+          | ((h == 24) & ((mi | s | ms) != 0))
+          | (src->tz.hour < _TZh_MIN) | (src->tz.hour > _TZh_MAX)
+          | (src->tz.minute < -59) | (src->tz.minute > 59)
+          | (tz->hour < _TZh_MIN) | (tz->hour > _TZh_MAX)
+          | (tz->minute < -59) | (tz->minute > 59);
+    ok = -(_sint)!bad;
+    mm = (mm & ok) | (1 & ~ok);
+    bad |= dd > __days_of_month(yy & ok, (_uint)mm);
+
+    /* Day 1 if bad, for the shift to stay in range. */
+    ok = -(_sint)!bad;
+    *y = (yy & ok) | (1 & ~ok);
+    *m = mm;
+    *d = (dd & ok) | (1 & ~ok);
+    *min = (h * 60 + mi
+            + (tz->hour - src->tz.hour) * 60
+            + tz->minute - src->tz.minute) & ok;
+    return bad ? CARGV_VAL_OVERFLOW : CARGV_OK;
+}
+
+/* Store a shifted datetime. See __local_load().
+
+[in] y, m, d, min: Date in range, and minutes of the day in [0..1440).
+[in] src: Datetime loaded. May be `dst`.
+*/
+static void __local_store(
+    _datetime *dst, _sint y, _sint m, _sint d, _sint min,
+    const _datetime *src, const _tz *tz)
+{
+    int date = src->day != _D_DEFAULT;
+
+    dst->year = (date && src->year != _Y_DEFAULT) ? y : src->year;
+    dst->month = date ? m : src->month;
+    dst->day = date ? d : src->day;
+    dst->hour = min / 60;
+    dst->minute = min % 60;
+    dst->second = src->second;
+    dst->milisecond = src->milisecond;
+    dst->tz.hour = tz->hour;
+    dst->tz.minute = tz->minute;
+}
+
+/* __civil_from_days() of a column, by _LOCAL_DAY_SHIFT. */
+static _ALWAYS_INLINE void __civil_col(_civil_cols *cols, int i, uint32_t days)
+{
+    uint32_t m, d, era, yoe, mp, doy, doe;
+
+    era = days / 146097;
+    doe = days - era * 146097;
+    yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp + 3 - 12 * (mp >= 10);
+    cols->y[i] = yoe + era * 400 + (m <= 2);
+    cols->m[i] = m;
+    cols->d[i] = d;
+}
+
+static _ALWAYS_INLINE void __shift_civil(_civil_cols *cols)
+{
+    uint32_t y, t, days, era, yoe, mp, doy, doe;
+    int i;
+
+    for (i = 0; i < _EPOCH_BLOCK; ++i) {
+        /* Whole days to shift, 2 more by _LOCAL_MIN_SHIFT */
+        t = cols->min[i];
+        days = t / 1440;
+        cols->min[i] = t % 1440;
+
+        /* __days_from_civil() */
+        y = cols->y[i] - (cols->m[i] <= 2);
+        era = y / 400;
+        yoe = y - era * 400;
+        mp = cols->m[i] + 9 - 12 * (cols->m[i] > 2);
+        doy = (153 * mp + 2) / 5 + cols->d[i] - 1;
+        doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        days += era * 146097 + doe - _LOCAL_MIN_SHIFT / 1440;
+
+        __civil_col(cols, i, days);
+    }
+}
+
+static _ALWAYS_INLINE void __civil_from_days_cols(_civil_cols *cols)
+{
+    int i;
+
+    for (i = 0; i < _EPOCH_BLOCK; ++i)
+        __civil_col(cols, i, cols->d[i]);
+}
+
+static void __shift_civil_scalar(_civil_cols *cols)
+{
+    __shift_civil(cols);
+}
+
+static void __civil_from_days_scalar(_civil_cols *cols)
+{
+    __civil_from_days_cols(cols);
+}
+
+static const struct _civil_kernel_t __civil_kernel_scalar = {
+    &__shift_civil_scalar, &__civil_from_days_scalar,
+};
+
+#ifdef _HAVE_AVX2_DISPATCH
+__attribute__((target("avx2")))
+static void __shift_civil_avx2(_civil_cols *cols)
+{
+    __shift_civil(cols);
+}
+
+__attribute__((target("avx2")))
+static void __civil_from_days_avx2(_civil_cols *cols)
+{
+    __civil_from_days_cols(cols);
+}
+
+static const struct _civil_kernel_t __civil_kernel_avx2 = {
+    &__shift_civil_avx2, &__civil_from_days_avx2,
+};
+#endif
+
+/* Pick the best kernel for this CPU. */
+static const struct _civil_kernel_t *__civil_kernel(void)
+{
+#ifdef _HAVE_AVX2_DISPATCH
+    if (__builtin_cpu_supports("avx2"))
+        return &__civil_kernel_avx2;
+#endif
+    return &__civil_kernel_scalar;
+}
+
+/* Convert a datetime between fixed time zones. See cargv_local_datetime(). */
+static int __local_datetime(_datetime *dst, const _datetime *src, const _tz *tz)
+{
+    _sint y, m, d, min, days;
+    int r;
+
+    if ((r = __local_load(&y, &m, &d, &min, src, tz)) < 0)
+        return r;
+    days = __floor_div(min, 1440);
+    __civil_from_days(&y, &m, &d, __days_from_civil(y, m, d) + days);
+    if (y < _Y_MIN || y > _Y_MAX)
+        return CARGV_VAL_OVERFLOW;
+    __local_store(dst, y, m, d, min - days * 1440, src, tz);
+    return CARGV_OK;
+}
+
+/* Time zones of the tz database.
+
+A zone is loaded from its TZif file once per process, and kept in a list
+until the process exits. Transitions are kept as sorted arrays of times
+and UTC offsets, without transitions that keep the offset, and looked up
+by a binary search. Times after the last transition follow the POSIX TZ
+rule at the end of the file, if any.
+
+Names failed to load are kept in a small ring, so that repeated bad names in
+arguments fail without touching the file system.
+*/
+#define _ZONE_NAME_MAX  64
+#define _ZONE_MISS_MAX  16
+#define _ZONE_DIR       "/usr/share/zoneinfo"
+#define _ZONE_RULE_DEFAULT  ",M3.2.0,M11.1.0"
+#define _ZONE_LOCALTIME     "/etc/localtime"
+
+/* A day of a POSIX TZ rule, Jn, n or Mm.w.d */
+typedef struct _zone_day_t {
+    char kind;      /* 'J', 'D' or 'M' */
+    int m, w, d;    /* Month, week and weekday, or the day of Jn and n */
+    _sint time;     /* Local time of the day in seconds, may be <0 or >24h */
+} _zone_day;
+
+/* A POSIX TZ rule, like `PST8PDT,M3.2.0,M11.1.0` */
+typedef struct _zone_rule_t {
+    _sint std, dst;     /* UTC offsets in seconds, east positive */
+    int has_dst;
+    _zone_day start, end;
+} _zone_rule;
+
+struct cargv_zone_t {
+    struct cargv_zone_t *next;
+    char name[_ZONE_NAME_MAX];
+    _len transc;        /* Number of transitions */
+    _sint *times;       /* Transition times in epoch seconds, ascending */
+    int32_t *offsets;   /* UTC offsets in seconds, from each transition */
+    _sint offset0;      /* UTC offset before the first transition */
+    int has_rule;       /* Follows `rule` after the last transition */
+    _zone_rule rule;
+};
+
+/* A zone name failed to load */
+typedef struct _zone_miss_t {
+    char name[_ZONE_NAME_MAX];
+    int r;              /* Error of the load, 0 if unused */
+} _zone_miss;
+
+static struct cargv_zone_t *__zones;   /* Loaded zones */
+static _zone_miss __zone_misses[_ZONE_MISS_MAX];   /* Ring of failed names */
+static unsigned __zone_missi;   /* Next slot of the ring */
+static const struct cargv_zone_t *__zone_localp;   /* Local zone, if resolved */
+static struct cargv_zone_t __zone_utc;  /* No transitions, UTC */
+
+#if defined(_HAVE_PTHREAD)
+  static pthread_mutex_t __zones_lock = PTHREAD_MUTEX_INITIALIZER;
+  #define _ZONES_LOCK()     pthread_mutex_lock(&__zones_lock)
+  #define _ZONES_UNLOCK()   pthread_mutex_unlock(&__zones_lock)
+#elif defined(_WIN32)
+  static SRWLOCK __zones_lock = SRWLOCK_INIT;
+  #define _ZONES_LOCK()     AcquireSRWLockExclusive(&__zones_lock)
+  #define _ZONES_UNLOCK()   ReleaseSRWLockExclusive(&__zones_lock)
+#else
+  #define _ZONES_LOCK()
+  #define _ZONES_UNLOCK()
+#endif
+
+/* Loaded zones are only pushed to the head of the list, and never changed
+after, so the list is read without the lock, if the head is published with
+release and read with acquire. */
+#if defined(__GNUC__)
+  #define _ZONES_HEAD()     __atomic_load_n(&__zones, __ATOMIC_ACQUIRE)
+  #define _ZONES_PUBLISH(z) __atomic_store_n(&__zones, (z), __ATOMIC_RELEASE)
+  #define _HAVE_ZONES_ACQUIRE  1
+#else
+  #define _ZONES_HEAD()     __zones
+  #define _ZONES_PUBLISH(z) (__zones = (z))
+#endif
+
+static _sint __cargv_read_be32(const unsigned char *p)
+{
+    return (int32_t)(((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16)
+                     | ((uint32_t)p[2] << 8) | (uint32_t)p[3]);
+}
+
+static _sint __cargv_read_be64(const unsigned char *p)
+{
+    return (_sint)(((uint64_t)(uint32_t)__cargv_read_be32(p) << 32)
+                   | (uint64_t)(uint32_t)__cargv_read_be32(p+4));
+}
+
+/* Skip a name of a POSIX TZ rule, <...> or 3 or more letters. */
+static _str __posix_name(_str t, _str e)
+{
+    _str s = t;
+
+    if (t < e && *t == '<') {
+        while (++t < e && *t != '>') {
+        }
+        return (t < e) ? t+1 : s;
+    }
+    while (t < e && ((*t >= 'A' && *t <= 'Z') || (*t >= 'a' && *t <= 'z')))
+        ++t;
+    return (t - s >= 3) ? t : s;
+}
+
+/* Read a time of a POSIX TZ rule, [+-]h[h[h]][:mm[:ss]].
+
+[out] return: End of the time, `t` if none.
+*/
+static _str __posix_time(_sint *val, _str t, _str e)
+{
+    _sint sign = 1, v[3] = {0, 0, 0};
+    _str s = t;
+    int i, n;
+
+    if (t < e && (*t == '+' || *t == '-'))
+        sign = (*t++ == '-') ? -1 : 1;
+    for (i = 0; i < 3; ++i) {
+        if (i > 0) {
+            if (!(t+1 < e && *t == ':' && __char_is(t[1], _CC_DIGIT)))
+                break;
+            ++t;
+        }
+        for (n = 0; t < e && n < 3 && __char_is(*t, _CC_DIGIT); ++n)
+            v[i] = v[i] * 10 + (*t++ - '0');
+        if (n == 0)
+            return s;
+    }
+    *val = sign * (v[0] * 3600 + v[1] * 60 + v[2]);
+    return t;
+}
+
+/* Read a small decimal number of a POSIX TZ rule. */
+static _str __posix_num(int *val, _str t, _str e, int max)
+{
+    _str s = t;
+    int v = 0;
+
+    while (t < e && __char_is(*t, _CC_DIGIT) && t - s < 3)
+        v = v * 10 + (*t++ - '0');
+    if (t == s || v > max)
+        return s;
+    *val = v;
+    return t;
+}
+
+/* Read a day of a POSIX TZ rule, ,Jn[/time] ,n[/time] or ,Mm.w.d[/time]. */
+static _str __posix_day(_zone_day *day, _str t, _str e)
+{
+    _str s = t, u;
+
+    if (!(t < e && *t++ == ','))
+        return s;
+    day->m = day->w = day->d = 0;
+    day->time = 2 * 3600;
+    if (t < e && *t == 'J') {
+        day->kind = 'J';
+        if ((u = __posix_num(&day->d, t+1, e, 365)) == t+1 || day->d < 1)
+            return s;
+    }
+    else if (t < e && *t == 'M') {
+        day->kind = 'M';
+        if ((u = __posix_num(&day->m, t+1, e, 12)) == t+1 || day->m < 1
+            || !(u < e && *u == '.')
+            || (t = __posix_num(&day->w, u+1, e, 5)) == u+1 || day->w < 1
+            || !(t < e && *t == '.')
+            || (u = __posix_num(&day->d, t+1, e, 6)) == t+1)
+            return s;
+    }
+    else {
+        day->kind = 'D';
+        if ((u = __posix_num(&day->d, t, e, 365)) == t)
+            return s;
+    }
+    t = u;
+    if (t < e && *t == '/') {
+        if ((u = __posix_time(&day->time, t+1, e)) == t+1)
+            return s;
+        t = u;
+    }
+    return t;
+}
+
+/* Read a POSIX TZ rule, std offset [dst [offset] [,start[/time],end[/time]]].
+
+[out] return: 1 if read, else 0.
+*/
+static int __posix_rule(_zone_rule *rule, _str t, _str e)
+{
+    _str u;
+
+    if ((u = __posix_name(t, e)) == t
+        || (t = __posix_time(&rule->std, u, e)) == u)
+        return 0;
+    rule->std = -rule->std;     /* POSIX offsets are west positive */
+    rule->has_dst = 0;
+    if (t == e)
+        return 1;
+
+    if ((u = __posix_name(t, e)) == t)
+        return 0;
+    if ((t = __posix_time(&rule->dst, u, e)) == u)
+        rule->dst = rule->std + 3600;
+    else
+        rule->dst = -rule->dst;
+    rule->has_dst = 1;
+
+    /* US rules if omitted */
+    if (t == e) {
+        t = _ZONE_RULE_DEFAULT;
+        e = t + sizeof(_ZONE_RULE_DEFAULT) - 1;
+    }
+    if ((u = __posix_day(&rule->start, t, e)) == t
+        || (t = __posix_day(&rule->end, u, e)) == u)
+        return 0;
+    return t == e;
+}
+
+/* Epoch day of a day of a POSIX TZ rule in a year. */
+static _sint __zone_day(const _zone_day *day, _sint year)
+{
+    _sint days, wd, d;
+
+    days = __days_from_civil(year, (day->kind == 'M') ? day->m : 1, 1);
+    if (day->kind == 'J')
+        return days + day->d - 1 + (day->d >= 60 && __leap(year, 2));
+    if (day->kind == 'D')
+        return days + day->d;
+
+    /* d-th weekday of w-th week, 1970-01-01 was Thursday */
+    wd = (days % 7 + 11) % 7;
+    d = (day->d - wd + 7) % 7 + 7 * (day->w - 1);
+    while (d >= __days_of_month(year, (_uint)day->m))
+        d -= 7;
+    return days + d;
+}
+
+/* Cut a span of times at a time, keeping `t` in it. */
+static void __zone_cut(_sint span[2], _sint t, _sint cut)
+{
+    if (cut <= t && cut > span[0])
+        span[0] = cut;
+    if (cut > t && cut < span[1])
+        span[1] = cut;
+}
+
+/* UTC offset of a POSIX TZ rule at an epoch time.
+
+[in,out] span: Times around `t` with the same offset, [span[0], span[1]).
+               Narrowed to the year of `t`.
+*/
+static _sint __zone_rule_offset(const _zone_rule *rule, _sint t, _sint span[2])
+{
+    _sint y, m, d, start, end;
+
+    if (!rule->has_dst)
+        return rule->std;
+
+    __civil_from_days(&y, &m, &d, __floor_div(t + rule->std, 86400));
+    start = __zone_day(&rule->start, y) * 86400
+            + rule->start.time - rule->std;
+    end = __zone_day(&rule->end, y) * 86400 + rule->end.time - rule->dst;
+    __zone_cut(span, t, __days_from_civil(y, 1, 1) * 86400 - rule->std);
+    __zone_cut(span, t, __days_from_civil(y+1, 1, 1) * 86400 - rule->std);
+    __zone_cut(span, t, start);
+    __zone_cut(span, t, end);
+    if (start < end)
+        return (t >= start && t < end) ? rule->dst : rule->std;
+    return (t >= end && t < start) ? rule->std : rule->dst;  /* southern */
+}
+
+/* UTC offset of a zone at an epoch time.
+
+[out] span: Times around `t` with the same offset, [span[0], span[1]).
+*/
+static _sint __zone_lookup(const struct cargv_zone_t *zone, _sint t,
+                           _sint span[2])
+{
+    _len lo = 0, hi = zone->transc, mid;
+
+    /* First transition after t */
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (zone->times[mid] <= t)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    span[0] = (lo == 0) ? _SINT_MIN : zone->times[lo-1];
+    span[1] = (lo == zone->transc) ? _SINT_MAX : zone->times[lo];
+    if (lo == zone->transc && zone->has_rule)
+        return __zone_rule_offset(&zone->rule, t, span);
+    return (lo == 0) ? zone->offset0 : zone->offsets[lo-1];
+}
+
+static _sint __zone_offset(const struct cargv_zone_t *zone, _sint t)
+{
+    _sint span[2];
+
+    return __zone_lookup(zone, t, span);
+}
+
+/* UTC offset of a zone at a local time in seconds.
+
+Local times skipped by a transition take the offset before it, and local
+times repeated take the earlier.
+*/
+static _sint __zone_local_offset(const struct cargv_zone_t *zone, _sint t)
+{
+    _sint before, after;
+
+    /* Offsets change by less than a day. */
+    before = __zone_offset(zone, t - 86400);
+    after = __zone_offset(zone, t + 86400);
+    if (before != after
+        && __zone_offset(zone, t - before) != before
+        && __zone_offset(zone, t - after) == after)
+        return after;
+    return before;
+}
+
+/* A span of times of a zone with one UTC offset, the last looked up.
+
+Values near each other, like a sorted column, are mostly in the span of
+the value before, and skip the lookup.
+*/
+typedef struct _zone_span_t {
+    const struct cargv_zone_t *zone;
+    _sint span[2];      /* [span[0], span[1]) */
+    _sint offset;
+} _zone_span;
+
+static void __zone_span_init(_zone_span *s, const struct cargv_zone_t *zone)
+{
+    s->zone = zone;
+    s->span[0] = s->span[1] = 0;
+    s->offset = 0;
+}
+
+/* UTC offset of the zone at an epoch time, in the span or looked up. */
+static _sint __zone_span_offset(_zone_span *s, _sint t)
+{
+    if (!(t >= s->span[0] && t < s->span[1]))
+        s->offset = __zone_lookup(s->zone, t, s->span);
+    return s->offset;
+}
+
+/* UTC offset of the zone at a local time. See __zone_local_offset(). */
+static _sint __zone_span_local(_zone_span *s, _sint t)
+{
+    _sint offset;
+
+    /* Offsets change by less than a day. */
+    if (t - 86400 >= s->span[0] && t + 86400 < s->span[1])
+        return s->offset;
+    offset = __zone_local_offset(s->zone, t);
+    __zone_span_offset(s, t - offset);
+    return offset;
+}
+
+/* Offset in seconds to a time zone, truncating seconds.
+
+[out] return: 1 if succeeded, CARGV_VAL_OVERFLOW if out of range.
+*/
+static int __zone_tz(_tz *tz, _sint offset)
+{
+    _sint H, M;
+
+    H = offset / 3600;
+    M = offset / 60 % 60;
+    if (!((H == _TZh_MIN && M == 0)
+          || (H == _TZh_MAX && M == 0)
+          || (H > _TZh_MIN && H < _TZh_MAX)))
+        return CARGV_VAL_OVERFLOW;
+    tz->hour = H;
+    tz->minute = M;
+    return 1;
+}
+
+/* Parse a TZif file into a zone.
+
+[out] return: 0 if succeeded, <0 if error.
+*/
+static int __zone_parse(
+    struct cargv_zone_t **zone,
+    const unsigned char *data, size_t len)
+{
+    struct cargv_zone_t *z;
+    const unsigned char *p, *end, *times, *types, *infos;
+    _sint cnt[6], off, prev, t, last;
+    size_t size, tsize;
+    _len i, n;
+    int k;
+
+    if (!data)
+        return CARGV_IO_ERROR;
+    end = data + len;
+    tsize = 4;
+    for (p = data;;) {
+        if (!((size_t)(end - p) >= 44 && memcmp(p, "TZif", 4) == 0))
+            return CARGV_IO_ERROR;
+        for (k = 0; k < 6; ++k) {
+            cnt[k] = (uint32_t)__cargv_read_be32(p + 20 + k*4);
+            if (cnt[k] > 0xFFFFFF)
+                return CARGV_IO_ERROR;
+        }
+        /* isutcnt, isstdcnt, leapcnt, timecnt, typecnt, charcnt */
+        size = (size_t)(cnt[3] * (_sint)(tsize + 1) + cnt[4] * 6 + cnt[5]
+                        + cnt[2] * (_sint)(tsize + 4) + cnt[1] + cnt[0]);
+        if (!(cnt[4] > 0 && (size_t)(end - p - 44) >= size))
+            return CARGV_IO_ERROR;
+
+        /* Version 2 and later repeat the data with 64bit times. */
+        if (tsize == 4 && p[4] >= '2') {
+            p += 44 + size;
+            tsize = 8;
+            continue;
+        }
+        break;
+    }
+    times = p + 44;
+    types = times + cnt[3] * (_sint)tsize;
+    infos = types + cnt[3];
+
+    if (!(z = (struct cargv_zone_t *)malloc(
+            sizeof(*z) + (size_t)cnt[3] * (sizeof(_sint) + sizeof(int32_t)))))
+        return CARGV_NO_MEMORY;
+    memset(z, 0, sizeof(*z));
+    z->times = (_sint *)(z + 1);
+    z->offsets = (int32_t *)(z->times + cnt[3]);
+
+    /* Keep transitions changing offsets only. */
+    z->offset0 = prev = __cargv_read_be32(infos);
+    last = _SINT_MIN;
+    for (i = n = 0; i < cnt[3]; ++i) {
+        t = (tsize == 8) ? __cargv_read_be64(times + i*8)
+                         : __cargv_read_be32(times + i*4);
+        if (types[i] >= cnt[4] || (i > 0 && t <= last)) {
+            free(z);
+            return CARGV_IO_ERROR;
+        }
+        last = t;
+        off = __cargv_read_be32(infos + types[i] * 6);
+        if (off != prev) {
+            z->times[n] = t;
+            z->offsets[n] = (int32_t)off;
+            ++n;
+            prev = off;
+        }
+    }
+    z->transc = n;
+
+    /* Footer, \n<POSIX TZ rule>\n */
+    p = infos + cnt[4] * 6 + cnt[5] + cnt[2] * (_sint)(tsize + 4)
+        + cnt[1] + cnt[0];
+    if (tsize == 8 && p < end && *p == '\n') {
+        times = (const unsigned char *)memchr(p+1, '\n', (size_t)(end - p - 1));
+        if (times && times > p+1)
+            z->has_rule = __posix_rule(&z->rule, (_str)p+1, (_str)times);
+    }
+
+    *zone = z;
+    return CARGV_OK;
+}
+
+/* See if a text is a zone name, like `America/Argentina/Buenos_Aires`.
+
+Checked before touching the file system. Each component starts with a letter,
+and has letters, digits, `_`, `+` and `-` only, so `.` and `..` never get
+into a path.
+*/
+static int __zone_name(_str text, _len len)
+{
+    _len i;
+
+    if (!(len > 0 && len < _ZONE_NAME_MAX))
+        return 0;
+    for (i = 0; i < len; ++i) {
+        if ((i == 0 || text[i-1] == '/')
+            ? !((text[i] >= 'A' && text[i] <= 'Z')
+                || (text[i] >= 'a' && text[i] <= 'z'))
+            : !(__char_is(text[i], _CC_DIGIT) || text[i] == '/'
+                || text[i] == '_' || text[i] == '+' || text[i] == '-'
+                || (text[i] >= 'A' && text[i] <= 'Z')
+                || (text[i] >= 'a' && text[i] <= 'z')))
+            return 0;
+    }
+    return text[len-1] != '/';
+}
+
+/* Read a zone from a TZif file.
+
+[in] name, len: Name of the zone, less than _ZONE_NAME_MAX.
+*/
+static int __zone_read(
+    struct cargv_zone_t **zone, const char *path, _str name, _len len)
+{
+    void *addr;
+    size_t size;
+    int r;
+
+    if ((r = __map_file(&addr, &size, path)) < 0)
+        return r;
+    r = __zone_parse(zone, (const unsigned char *)addr, size);
+    if (addr)
+        __unmap_file(addr, size);
+    if (r == CARGV_OK) {
+        memcpy((*zone)->name, name, (size_t)len);
+        (*zone)->name[len] = '\0';
+    }
+    return r;
+}
+
+/* Find a loaded zone. Safe without the lock. See _ZONES_HEAD(). */
+static struct cargv_zone_t *__zone_find(_str name, _len len)
+{
+    struct cargv_zone_t *z;
+
+    for (z = _ZONES_HEAD(); z; z = z->next) {
+        if (strncmp(z->name, name, (size_t)len) == 0 && z->name[len] == '\0')
+            return z;
+    }
+    return NULL;
+}
+
+/* Load a zone, or find the loaded. Called with the lock held. */
+static int __zone_load_locked(
+    const struct cargv_zone_t **zone, _str name, _len len)
+{
+    char path[_EXPAND_PATH_MAX];
+    struct cargv_zone_t *z, *found;
+    _zone_miss *m;
+    const char *dir;
+    size_t dirlen;
+    int r, i;
+
+    if (!__zone_name(name, len))
+        return CARGV_BAD_PARAM;
+
+    if ((found = __zone_find(name, len)) != NULL) {
+        *zone = found;
+        return CARGV_OK;
+    }
+    for (i = 0; i < _ZONE_MISS_MAX; ++i) {
+        m = &__zone_misses[i];
+        if (m->r < 0 && strncmp(m->name, name, (size_t)len) == 0
+            && m->name[len] == '\0')
+            return m->r;
+    }
+
+    if (!(dir = getenv("TZDIR")) || !*dir)
+        dir = _ZONE_DIR;
+    dirlen = strlen(dir);
+    if (dirlen + 1 + (size_t)len >= sizeof(path))
+        return CARGV_IO_ERROR;
+    memcpy(path, dir, dirlen);
+    path[dirlen] = '/';
+    memcpy(path + dirlen + 1, name, (size_t)len);
+    path[dirlen + 1 + len] = '\0';
+
+    if ((r = __zone_read(&z, path, name, len)) < 0) {
+        if (r != CARGV_NO_MEMORY) {     /* may succeed later */
+            m = &__zone_misses[__zone_missi++ % _ZONE_MISS_MAX];
+            memcpy(m->name, name, (size_t)len);
+            m->name[len] = '\0';
+            m->r = r;
+        }
+        return r;
+    }
+    z->next = __zones;
+    _ZONES_PUBLISH(z);
+    *zone = z;
+    return CARGV_OK;
+}
+
+/* Load a zone, or find the loaded. See cargv_zone_load().
+
+A loaded zone is found without the lock. The lock is taken to load, or to
+see failed names.
+*/
+static int __zone_load(const struct cargv_zone_t **zone, _str name, _len len)
+{
+    int r;
+
+#ifdef _HAVE_ZONES_ACQUIRE
+    if (len > 0 && len < _ZONE_NAME_MAX
+        && (*zone = __zone_find(name, len)) != NULL)
+        return CARGV_OK;
+#endif
+    _ZONES_LOCK();
+    r = __zone_load_locked(zone, name, len);
+    _ZONES_UNLOCK();
+    return r;
+}
+
+/* Resolve the local zone, as TZ or /etc/localtime tells, else UTC.
+Called with the lock held.
+*/
+static const struct cargv_zone_t *__zone_local_resolve(void)
+{
+    const struct cargv_zone_t *found;
+    struct cargv_zone_t *z;
+    const char *tz;
+
+    if (!(tz = getenv("TZ")))
+        return (__zone_read(&z, _ZONE_LOCALTIME, "", 0) == CARGV_OK)
+               ? z : &__zone_utc;
+    if (*tz == ':')
+        ++tz;
+    if (*tz == '/')
+        return (__zone_read(&z, tz, "", 0) == CARGV_OK) ? z : &__zone_utc;
+    if (__zone_load_locked(&found, tz, (_len)strlen(tz)) == CARGV_OK)
+        return found;
+
+    /* POSIX TZ rule, like `KST-9` or `PST8PDT,M3.2.0,M11.1.0` */
+    if (!(z = (struct cargv_zone_t *)malloc(sizeof(*z))))
+        return &__zone_utc;
+    memset(z, 0, sizeof(*z));
+    if (!__posix_rule(&z->rule, tz, tz + strlen(tz))) {
+        free(z);
+        return &__zone_utc;
+    }
+    z->has_rule = 1;
+    z->offset0 = z->rule.std;
+    return z;
+}
+
+static void __zone_local_init(void)
+{
+    _ZONES_LOCK();
+    __zone_localp = __zone_local_resolve();
+    _ZONES_UNLOCK();
+}
+
+/* Resolve the local zone once, without locking once resolved. */
+#if defined(_HAVE_PTHREAD)
+  static pthread_once_t __zone_local_once = PTHREAD_ONCE_INIT;
+  #define _ZONE_LOCAL_ONCE() \
+      pthread_once(&__zone_local_once, __zone_local_init)
+#elif defined(_WIN32)
+  static INIT_ONCE __zone_local_once = INIT_ONCE_STATIC_INIT;
+
+  static BOOL CALLBACK __zone_local_init_once(
+      PINIT_ONCE once, PVOID param, PVOID *ctx)
+  {
+      (void)once, (void)param, (void)ctx;
+      __zone_local_init();
+      return TRUE;
+  }
+  #define _ZONE_LOCAL_ONCE() \
+      InitOnceExecuteOnce(&__zone_local_once, __zone_local_init_once, \
+                          NULL, NULL)
+#else
+  #define _ZONE_LOCAL_ONCE() \
+      ((void)(__zone_localp || (__zone_local_init(), 0)))
+#endif
+
+/* The local zone, resolved once. See cargv_zone_local(). */
+static const struct cargv_zone_t *__zone_local(void)
+{
+    _ZONE_LOCAL_ONCE();
+    return __zone_localp;
+}
+
+/* Find a zone suffix of a datetime argument, `[Area/Location]`.
+
+[out] return: 1 if found and loaded, 0 if none, <0 if not loaded.
+[out] zone: Loaded zone.
+[in/out] last: Zone of the last suffix, tried before looking up zones.
+               Null if none yet. Kept per thread.
+[out] textend: Start of the suffix, if found.
+*/
+static int __arg_zone_suffix(
+    const struct cargv_zone_t **zone, const struct cargv_zone_t **last,
+    _str *textend, _str text)
+{
+    _str e = *textend, t;
+    _len len;
+    int r;
+
+    if (!(e > text && e[-1] == ']'))
+        return 0;
+    for (t = e-1; t > text && t[-1] != '['; --t) {
+    }
+    if (t == text)
+        return 0;
+    len = e-1 - t;
+    if (*last && len > 0 && strncmp((*last)->name, t, (size_t)len) == 0
+        && (*last)->name[len] == '\0')
+        *zone = *last;
+    else if ((r = __zone_load(zone, t, len)) < 0)
+        return r;
+    else
+        *last = *zone;
+    *textend = t-1;
+    return 1;
+}
+
+/* Read a datetime argument with an optional zone suffix. See cargv_datetime().
+
+An omitted time zone is resolved by the zone, at the datetime if it has the
+year, or else at the current time.
+
+[out] return: 1 if read, 0 if not matched, <0 if matched but wrong.
+[in/out] cargv: cargv object to predict the format with, or null to read in
+                any format without prediction, like from worker threads.
+[in/out] last: Zone of the last suffix read. See __arg_zone_suffix().
+*/
+static int __zoned_datetime(
+    struct cargv_t *cargv, int format, int parts,
+    const struct cargv_zone_t **last,
+    _ymd *d, _hms *h, _tz *tz, _str text, _str textend)
+{
+    const struct cargv_zone_t *zone;
+    _datetime v;
+    _sint t;
+    int r, rz;
+
+    if ((rz = __arg_zone_suffix(&zone, last, &textend, text)) < 0)
+        return 0;
+    if (cargv)
+        r = __predict_datetime(cargv, format, parts, d, h, tz, text, textend);
+    else if (parts == _FMT_TIME)
+        r = __arg_time(h, tz, text, textend);
+    else
+        r = __arg_datetime(d, h, tz, text, textend);
+    if (r <= 0 || rz == 0 || tz->hour != _TZh_DEFAULT)
+        return r;
+
+    /* Offset of the zone at the datetime, or now without the date */
+    if ((parts & _FMT_DATE) && d->year != _Y_DEFAULT) {
+        v.year = d->year;
+        v.month = d->month;
+        v.day = d->day;
+        v.hour = h->hour;
+        v.minute = h->minute;
+        v.second = h->second;
+        v.milisecond = h->milisecond;
+        v.tz.hour = v.tz.minute = 0;
+        if ((r = __datetime_to_epoch(&t, &v, 1)) < 0)
+            return r;
+        t = __zone_local_offset(zone, t);
+    }
+    else
+        t = __zone_offset(zone, (_sint)time(NULL));
+    return __zone_tz(tz, t);
+}
+
+/* Read a zone name as a timezone argument, at the current time.
+
+[out] return: 1 if read, 0 if not matched, <0 if matched but wrong.
+*/
+static int __arg_timezone_zone(_tz *tz, _str text, _str textend)
+{
+    const struct cargv_zone_t *zone;
+
+    if (textend - text > 2 && text[0] == '[' && textend[-1] == ']')
+        ++text, --textend;
+    if (__zone_load(&zone, text, textend - text) < 0)
+        return 0;
+    return __zone_tz(tz, __zone_offset(zone, (_sint)time(NULL)));
+}
+
+enum cargv_err_t cargv_zone_load(
+    const struct cargv_zone_t **zone,
+    const char *name)
+{
+    return (enum cargv_err_t)__zone_load(zone, name, (_len)strlen(name));
+}
+
+enum cargv_err_t cargv_zone_offset(
+    struct cargv_timezone_t *tz,
+    const struct cargv_zone_t *zone,
+    cargv_int_t epoch)
+{
+    _sint dmin, dmax;
+    int r;
+
+    /* Within -9999..9999 */
+    dmin = __days_from_civil(_Y_MIN, 1, 1);
+    dmax = __days_from_civil(_Y_MAX, 12, 31);
+    if (epoch < (dmin - 1) * 86400 || epoch > (dmax + 1) * 86400)
+        return CARGV_VAL_OVERFLOW;
+    if ((r = __zone_tz(tz, __zone_offset(zone, epoch))) < 0)
+        return (enum cargv_err_t)r;
+    return CARGV_OK;
+}
+
+enum cargv_err_t cargv_zone_local_offset(
+    struct cargv_timezone_t *tz,
+    const struct cargv_zone_t *zone,
+    const struct cargv_datetime_t *local)
+{
+    _datetime v;
+    _sint t;
+    int r;
+
+    memcpy(&v, local, sizeof(v));
+    v.tz.hour = v.tz.minute = 0;
+    if ((r = __datetime_to_epoch(&t, &v, 1)) < 0)
+        return (enum cargv_err_t)r;
+    if ((r = __zone_tz(tz, __zone_local_offset(zone, t))) < 0)
+        return (enum cargv_err_t)r;
+    return CARGV_OK;
+}
+
+/* Convert one datetime in the local zone. See __datetime_to_epoch(). */
+static int __datetime_to_epoch_local(
+    _sint *epoch, const _datetime *v, _sint scale, _zone_span *local)
+{
+    _datetime w;
+    _sint sec, off, lim;
+    int r;
+
+    /* Local time as if in UTC, less the offset */
+    memcpy(&w, v, sizeof(w));
+    w.tz.hour = w.tz.minute = 0;
+    if ((r = __datetime_to_epoch(epoch, &w, scale)) < 0)
+        return r;
+    sec = __floor_div(*epoch, scale);
+    if ((r = __zone_tz(&w.tz, __zone_span_local(local, sec))) < 0)
+        return r;
+    off = w.tz.hour * 3600 + w.tz.minute * 60;
+
+    lim = _SINT_MAX / scale - 1;
+    if (sec - off > lim || sec - off < -lim)
+        return CARGV_VAL_OVERFLOW;
+    *epoch -= off * scale;
+    return CARGV_OK;
+}
+
+/* Convert one epoch time in the local zone. See __epoch_to_datetime(). */
+static int __epoch_to_datetime_local(
+    _datetime *dst, _sint epoch, _sint scale, _zone_span *local)
+{
+    _tz tz;
+    _sint sec;
+    int r;
+
+    /* Out of range is left to __epoch_to_datetime(). */
+    sec = __floor_div(epoch, scale);
+    memcpy(&tz, &_TZ_0, sizeof(tz));
+    if (sec > (__days_from_civil(_Y_MIN, 1, 1) - 1) * 86400
+        && sec < (__days_from_civil(_Y_MAX, 12, 31) + 1) * 86400
+        && (r = __zone_tz(&tz, __zone_span_offset(local, sec))) < 0)
+        return r;
+    return __epoch_to_datetime(dst, epoch, scale, &tz);
+}
+
+enum cargv_err_t cargv_zone_local(const struct cargv_zone_t **zone)
+{
+    *zone = __zone_local();
+    return CARGV_OK;
+}
+
+enum cargv_err_t cargv_datetime_to_epoch(
+    cargv_int_t *epoch,
+    const struct cargv_datetime_t *src,
+    enum cargv_epoch_unit_t unit)
+{
+    _zone_span local;
+
+    if (!(unit >= CARGV_EPOCH_SECOND && unit <= CARGV_EPOCH_NANOSECOND))
+        return CARGV_BAD_PARAM;
+
+    if (__tz_local(&src->tz)) {
+        __zone_span_init(&local, __zone_local());
+        return (enum cargv_err_t)__datetime_to_epoch_local(
+            epoch, src, _EPOCH_SCALE[unit], &local);
+    }
+    return (enum cargv_err_t)__datetime_to_epoch(
+        epoch, src, _EPOCH_SCALE[unit]);
+}
+
+cargv_len_t cargv_datetimes_to_epochs(
+    cargv_int_t *epochs,
+    const struct cargv_datetime_t *vals, cargv_len_t valc,
+    enum cargv_epoch_unit_t unit)
+{
+    _zone_span local;
+    _sint scale;
+    _len i, k, n;
+    int r;
+
+    if (!(unit >= CARGV_EPOCH_SECOND && unit <= CARGV_EPOCH_NANOSECOND))
+        return CARGV_BAD_PARAM;
+    scale = _EPOCH_SCALE[unit];
+    local.zone = NULL;
+
+    /* Convert by blocks, and look for the failure, or values in the local
+       time zone, only if a block failed. Blocks starting in the local time
+       zone are taken as in it. */
+    for (i = 0; i < valc; i += n) {
+        n = (valc - i < _EPOCH_BLOCK) ? valc - i : _EPOCH_BLOCK;
+        if (!__tz_local(&vals[i].tz)) {
+            for (r = 0, k = i; k < i+n; ++k)
+                r |= __datetime_to_epoch(&epochs[k], &vals[k], scale);
+            if (r == 0)
+                continue;
+        }
+        for (k = i; k < i+n; ++k) {
+            if (!__tz_local(&vals[k].tz))
+                r = __datetime_to_epoch(&epochs[k], &vals[k], scale);
+            else {
+                if (!local.zone)
+                    __zone_span_init(&local, __zone_local());
+                r = __datetime_to_epoch_local(
+                    &epochs[k], &vals[k], scale, &local);
+            }
+            if (r != 0)
+                return k;
+        }
+    }
+    return valc;
+}
+
+enum cargv_err_t cargv_epoch_to_datetime(
+    struct cargv_datetime_t *dst,
+    cargv_int_t epoch,
+    enum cargv_epoch_unit_t unit,
+    const struct cargv_timezone_t *tz)
+{
+    _zone_span local;
+    int r;
+
+    if (!(unit >= CARGV_EPOCH_SECOND && unit <= CARGV_EPOCH_NANOSECOND))
+        return CARGV_BAD_PARAM;
+    if ((r = __epoch_tz(&tz)) < 0)
+        return (enum cargv_err_t)r;
+
+    if (r > 0) {
+        __zone_span_init(&local, __zone_local());
+        return (enum cargv_err_t)__epoch_to_datetime_local(
+            dst, epoch, _EPOCH_SCALE[unit], &local);
+    }
+    return (enum cargv_err_t)__epoch_to_datetime(
+        dst, epoch, _EPOCH_SCALE[unit], tz);
+}
+
+cargv_len_t cargv_epochs_to_datetimes(
+    struct cargv_datetime_t *dst,
+    const cargv_int_t *epochs, cargv_len_t valc,
+    enum cargv_epoch_unit_t unit,
+    const struct cargv_timezone_t *tz)
+{
+    const struct _civil_kernel_t *kernel;
+    _civil_cols cols;
+    _zone_span local;
+    _sint scale, days;
+    _len i, k, n;
+    int r;
+
+    if (!(unit >= CARGV_EPOCH_SECOND && unit <= CARGV_EPOCH_NANOSECOND))
+        return CARGV_BAD_PARAM;
+    if ((r = __epoch_tz(&tz)) < 0)
+        return r;
+    scale = _EPOCH_SCALE[unit];
+    kernel = __civil_kernel();
+
+    if (r > 0) {
+        __zone_span_init(&local, __zone_local());
+        for (k = 0; k < valc; ++k)
+            if (__epoch_to_datetime_local(&dst[k], epochs[k], scale, &local))
+                return k;
+        return valc;
+    }
+    for (i = 0; i < valc; i += n) {
+        n = (valc - i < _EPOCH_BLOCK) ? valc - i : _EPOCH_BLOCK;
+        for (r = 0, k = 0; k < n; ++k) {
+            r |= __epoch_to_time(&dst[i+k], &days, epochs[i+k], scale, tz);
+            cols.d[k] = (uint32_t)(days + _LOCAL_DAY_SHIFT);
+        }
+        for (; k < _EPOCH_BLOCK; ++k)
+            cols.d[k] = _LOCAL_DAY_SHIFT;
+        kernel->from_days(&cols);
+        for (k = 0; k < n; ++k) {
+            dst[i+k].year = (_sint)cols.y[k] - _LOCAL_Y_SHIFT;
+            dst[i+k].month = cols.m[k];
+            dst[i+k].day = cols.d[k];
+        }
+        if (r != 0)
+            for (k = i; k < i+n; ++k)
+                if (__epoch_to_datetime(&dst[k], epochs[k], scale, tz) != 0)
+                    return k;
+    }
+    return valc;
+}
+
+/* Convert a datetime, in the local time zone or not. See
+   cargv_local_datetime().
+
+[in/out] local: Span of the local zone, initialized if its zone is null.
+[in/out] now:   Current time, fetched if less than 0.
+*/
+static int __local_datetime_any(
+    _datetime *dst, const _datetime *src, const _tz *tz,
+    _zone_span *local, _sint *now)
+{
+    _datetime s;
+    _tz z;
+    _sint t;
+    int r;
+
+    if (!__tz_local(&src->tz) && !__tz_local(tz))
+        return __local_datetime(dst, src, tz);
+
+    /* Offsets of the local zone at the datetime, or now without the year */
+    if (!local->zone)
+        __zone_span_init(local, __zone_local());
+    if (*now < 0)
+        *now = (_sint)time(NULL);
+    memcpy(&s, src, sizeof(s));
+    if (__tz_local(&s.tz)) {
+        s.tz.hour = s.tz.minute = 0;
+        if (s.year == _Y_DEFAULT)
+            t = __zone_span_offset(local, *now);
+        else if ((r = __datetime_to_epoch(&t, &s, 1)) < 0)
+            return r;
+        else
+            t = __zone_span_local(local, t);
+        if ((r = __zone_tz(&s.tz, t)) < 0)
+            return r;
+    }
+    if (__tz_local(tz)) {
+        if (s.year == _Y_DEFAULT)
+            t = *now;
+        else if ((r = __datetime_to_epoch(&t, &s, 1)) < 0)
+            return r;
+        if ((r = __zone_tz(&z, __zone_span_offset(local, t))) < 0)
+            return r;
+        tz = &z;
+    }
+    return __local_datetime(dst, &s, tz);
+}
+
+enum cargv_err_t cargv_local_datetime(
+    struct cargv_datetime_t *dst,
+    const struct cargv_datetime_t *src,
+    const struct cargv_timezone_t *tz)
+{
+    _zone_span local;
+    _sint now = -1;
+
+    local.zone = NULL;
+    return (enum cargv_err_t)__local_datetime_any(dst, src, tz, &local, &now);
+}
+
+cargv_len_t cargv_local_datetimes(
+    struct cargv_datetime_t *dst,
+    const struct cargv_datetime_t *src, cargv_len_t valc,
+    const struct cargv_timezone_t *tz)
+{
+    const struct _civil_kernel_t *kernel;
+    _civil_cols cols;
+    _zone_span local;
+    _sint y, m, d, min, now = -1;
+    _len i, k, n;
+    int r, loc;
+
+    if ((loc = __epoch_tz(&tz)) < 0)
+        return loc;
+    kernel = __civil_kernel();
+    local.zone = NULL;
+
+    /* Shift by blocks between fixed time zones, and store only if the whole
+       block succeeded, as `dst` may be `src`. Blocks in the local time zone,
+       or failed, are converted value by value. */
+    for (i = 0; i < valc; i += n) {
+        n = (valc - i < _EPOCH_BLOCK) ? valc - i : _EPOCH_BLOCK;
+        for (r = loc, k = 0; k < n; ++k)
+            r |= __tz_local(&src[i+k].tz);
+        if (r == 0) {
+            for (k = 0; k < n; ++k) {
+                r |= __local_load(&y, &m, &d, &min, &src[i+k], tz);
+                cols.y[k] = (uint32_t)(y + _LOCAL_Y_SHIFT);
+                cols.m[k] = (uint32_t)m;
+                cols.d[k] = (uint32_t)d;
+                cols.min[k] = (uint32_t)(min + _LOCAL_MIN_SHIFT);
+            }
+            for (; k < _EPOCH_BLOCK; ++k) {
+                cols.y[k] = _LOCAL_Y_SHIFT;
+                cols.m[k] = cols.d[k] = 1;
+                cols.min[k] = _LOCAL_MIN_SHIFT;
+            }
+        }
+        if (r == 0) {
+            kernel->shift(&cols);
+            for (k = 0; k < n; ++k)
+                r |= (cols.y[k] < _LOCAL_Y_SHIFT + _Y_MIN)
+                     | (cols.y[k] > _LOCAL_Y_SHIFT + _Y_MAX);
+        }
+        if (r == 0) {
+            for (k = 0; k < n; ++k)
+                __local_store(&dst[i+k], (_sint)cols.y[k] - _LOCAL_Y_SHIFT,
+                              cols.m[k], cols.d[k], cols.min[k],
+                              &src[i+k], tz);
+            continue;
+        }
+        for (k = i; k < i+n; ++k)
+            if (__local_datetime_any(&dst[k], &src[k], tz, &local, &now))
+                return k;
+    }
+    return valc;
+}
+
+cargv_len_t cargv_degree(
     struct cargv_t *cargv,
     const char *name,
-    cargv_uint_t *vals, cargv_len_t valc)
+    struct cargv_degree_t *vals, cargv_len_t valc)
 {
     int r;
-    _uint *v, n;
-    _str *a, t, e;
+    _cursor cur;
+    _degree *v;
+    _str a, t, e;
 
-    a = cargv->args;
+    __cursor_init(&cur, cargv);
     v = vals;
-    while (a < cargv->argend && v - vals < valc) {
-        t = *a;
-        e = t + strlen(t);
-        if ((r = __read_uint_dec(&n, &t, t, e)) == 0)
+    while (v - vals < valc && __cursor_get(&cur, &a, &e)) {
+        if ((r = __read_iso6709_degree(v, &t, (t = a), e)) == 0)
             break;
         if (!__match_end(t, e))
             break;
         if (r < 0)
-            return err_val_result(cargv, name, "unsigned integer", *a, r);
+            return err_val_result(cargv, name, "degree", cur.i, a, e, r);
 
-        *v++ = n;
-        a++;
+        ++v;
+        __cursor_next(&cur);
     }
-    return (int)(v-vals);
+    return v-vals;
 }
 
-int cargv_date(
+cargv_len_t cargv_geocoord(
     struct cargv_t *cargv,
     const char *name,
-    struct cargv_datetime_t *vals, cargv_len_t valc)
+    struct cargv_geocoord_t *vals, cargv_len_t valc)
 {
     int r;
-    _datetime *v;
-    _ymd d;
-    _str *a, t, e;
+    _cursor cur;
+    _geocoord *v;
+    _str a, t, e;
 
-    a = cargv->args;
+    __cursor_init(&cur, cargv);
     v = vals;
-    while (a < cargv->argend && v - vals < valc) {
-        t = *a;
-        e = t + strlen(t);
-        if ((r = __read_iso8601_YMD(&d, &t, t, e)) == 0
-            && (r = __read_iso8601_YM(&d, &t, t, e)) == 0
-            && (r = __read_iso8601_Y(&d, &t, t, e)) == 0
-            && (r = __read_iso8601_MD(&d, &t, t, e)) == 0)
+    while (v - vals < valc && __cursor_get(&cur, &a, &e)) {
+        if ((r = __read_iso6709_geocoord(v, &t, (t = a), e)) == 0)
             break;
         if (!__match_end(t, e))
             break;
         if (r < 0)
-            return err_val_result(cargv, name, "date", *a, r);
+            return err_val_result(cargv, name, "geocoord", cur.i, a, e, r);
 
-        v->year = d.year;
-        v->month = d.month;
-        v->day = d.day;
-        v->hour = _h_DEFAULT;
-        v->minute = _m_DEFAULT;
-        v->second = _s_DEFAULT;
-        v->milisecond = _ms_DEFAULT;
-        v->tz.hour = _TZh_DEFAULT;
-        v->tz.minute = _TZm_DEFAULT;
         ++v;
-        ++a;
+        __cursor_next(&cur);
     }
-    return (int)(v-vals);
+    return v-vals;
+}
+
+_real cargv_get_degree(const struct cargv_degree_t *val)
+{
+    return (_real)val->degree + (_real)val->microdegree / 1E+6
+        + ((_real)val->minute + (_real)val->microminute / 1E+6) / 60.0
+        + ((_real)val->second + (_real)val->microsecond / 1E+6) / 3600.0;
+}
+
+_sint cargv_get_nanodegree(const struct cargv_degree_t *val)
+{
+    _sint arc, sign;
+
+    /* Minutes and seconds in microseconds of arc. All members share sign. */
+    arc = (val->minute * 1000000 + val->microminute) * 60
+          + val->second * 1000000 + val->microsecond;
+    sign = (arc < 0) ? -1 : 1;
+
+    return val->degree * 1000000000 + val->microdegree * 1000
+        + (arc * 1000 + sign * 1800) / 3600;
 }
 
-int cargv_time(
+cargv_len_t cargv_degree_real(
     struct cargv_t *cargv,
     const char *name,
-    struct cargv_datetime_t *vals, cargv_len_t valc)
+    cargv_real_t *degrees, cargv_len_t valc)
 {
-    int rh, rz;
-    _datetime *v;
-    _hms h;
-    _tz tz;
-    _str *a, t, e;
-
-    a = cargv->args;
-    v = vals;
-    while (a < cargv->argend && v - vals < valc) {
-        t = *a;
-        e = t + strlen(t);
-
-        /* <hms>[z] */
-        if ((rh = __read_iso8601_hms(&h, &t, t, e)) == 0
-            && (rh = __read_iso8601_hm(&h, &t, t, e)) == 0
-            && (rh = __read_iso8601_h(&h, &t, t, e)) == 0)
+    int r;
+    _cursor cur;
+    _real *v;
+    _degree d;
+    _str a, t, e;
+
+    __cursor_init(&cur, cargv);
+    v = degrees;
+    while (v - degrees < valc && __cursor_get(&cur, &a, &e)) {
+        if ((r = __read_iso6709_degree(&d, &t, (t = a), e)) == 0)
             break;
-        if ((rz = __read_iso8601_tz(&tz, &t, t, e)) == 0)
-            memcpy(&tz, &_TZ_DEFAULT, sizeof(tz));
         if (!__match_end(t, e))
             break;
-        if (rh < 0)
-            return err_val_result(cargv, name, "time", *a, rh);
-        if (rz < 0)
-            return err_val_result(cargv, name, "time", *a, rz);
+        if (r < 0)
+            return err_val_result(cargv, name, "degree", cur.i, a, e, r);
 
-        v->year = _Y_DEFAULT;
-        v->month = _M_DEFAULT;
-        v->day = _D_DEFAULT;
-        v->hour = h.hour;
-        v->minute = h.minute;
-        v->second = h.second;
-        v->milisecond = h.milisecond;
-        memcpy(&v->tz, &tz, sizeof(v->tz));
-        ++v;
-        ++a;
+        *v++ = cargv_get_degree(&d);
+        __cursor_next(&cur);
     }
-    return (int)(v-vals);
+    return v-degrees;
 }
 
-int cargv_timezone(
+cargv_len_t cargv_degree_nano(
     struct cargv_t *cargv,
     const char *name,
-    struct cargv_timezone_t *vals, cargv_len_t valc)
+    cargv_int_t *nanodegrees, cargv_len_t valc)
 {
     int r;
-    _tz *v, z;
-    _str *a, t, e;
-
-    a = cargv->args;
-    v = vals;
-    while (a < cargv->argend && v - vals < valc) {
-        t = *a;
-        e = t + strlen(t);
-        if ((r = __read_iso8601_tz(&z, &t, t, e)) == 0)
+    _cursor cur;
+    _sint *v;
+    _degree d;
+    _str a, t, e;
+
+    __cursor_init(&cur, cargv);
+    v = nanodegrees;
+    while (v - nanodegrees < valc && __cursor_get(&cur, &a, &e)) {
+        if ((r = __read_iso6709_degree(&d, &t, (t = a), e)) == 0)
             break;
         if (!__match_end(t, e))
             break;
         if (r < 0)
-            return err_val_result(cargv, name, "timezone", *a, r);
+            return err_val_result(cargv, name, "degree", cur.i, a, e, r);
 
-        memcpy(v++, &z, sizeof(*v));
-        ++a;
+        *v++ = cargv_get_nanodegree(&d);
+        __cursor_next(&cur);
     }
-    return (int)(v-vals);
+    return v-nanodegrees;
 }
 
-int cargv_datetime(
+cargv_len_t cargv_geocoord_real(
     struct cargv_t *cargv,
     const char *name,
-    struct cargv_datetime_t *vals, cargv_len_t valc)
+    cargv_real_t *lats, cargv_real_t *lons, cargv_len_t valc)
 {
-    _datetime *v;
-    _ymd d;
-    _hms h;
-    _tz tz;
-    _str *a, t, e;
-    int rd = 0, rh = 0, rz = 0;
-
-    a = cargv->args;
-    v = vals;
-    while (a < cargv->argend && v - vals < valc) {
-        t = *a;
-        e = t + strlen(t);
-
-        /* <date>T<time>[tz] */
-        if (((rd = __read_iso8601_YMD(&d, &t, (t = *a), e)) != 0
-            || (rd = __read_iso8601_YM(&d, &t, t, e)) != 0
-            || (rd = __read_iso8601_Y(&d, &t, t, e)) != 0
-            || (rd = __read_iso8601_MD(&d, &t, t, e)) != 0)
-            && __match_chars_set(&t, t, e, "T ", 2, 1, 1) == 1
-            && ((rh = __read_iso8601_hms(&h, &t, t, e)) != 0
-                || (rh = __read_iso8601_hm(&h, &t, t, e)) != 0
-                || (rh = __read_iso8601_h(&h, &t, t, e)) != 0)) {
-            if ((rz = __read_iso8601_tz(&tz, &t, t, e)) == 0)
-                memcpy(&tz, &_TZ_DEFAULT, sizeof(tz));
-        }
-        /* <date> */
-        else if ((rd = __read_iso8601_YMD(&d, &t, (t = *a), e)) != 0
-                || (rd = __read_iso8601_YM(&d, &t, t, e)) != 0
-                || (rd = __read_iso8601_MD(&d, &t, t, e)) != 0) {
-            memcpy(&h, &_HMS_DEFAULT, sizeof(h));
-            memcpy(&tz, &_TZ_DEFAULT, sizeof(tz));
-        }
-        /* <time>[tz] */
-        else if ((rh = __read_iso8601_hms(&h, &t, (t = *a), e)) != 0
-                 || (rh = __read_iso8601_hm(&h, &t, t, e)) != 0) {
-            memcpy(&d, &_YMD_DEFAULT, sizeof(d));
-            if ((rz = __read_iso8601_tz(&tz, &t, t, e)) == 0)
-                memcpy(&tz, &_TZ_DEFAULT, sizeof(tz));
-        }
-        /* <hour><tz> */
-        else if ((rh = __read_iso8601_h(&h, &t, t, e)) != 0
-                 && (rz = __read_iso8601_tz(&tz, &t, t, e)) != 0) {
-            memcpy(&d, &_YMD_DEFAULT, sizeof(d));
-        }
-        /* <year> */
-        else if ((rd = __read_iso8601_Y(&d, &t, (t = *a), e)) != 0) {
-            memcpy(&h, &_HMS_DEFAULT, sizeof(h));
-            memcpy(&tz, &_TZ_DEFAULT, sizeof(tz));
-        }
-        else
+    int r;
+    _cursor cur;
+    _len i;
+    _geocoord g;
+    _str a, t, e;
+
+    __cursor_init(&cur, cargv);
+    i = 0;
+    while (i < valc && __cursor_get(&cur, &a, &e)) {
+        if ((r = __read_iso6709_geocoord(&g, &t, (t = a), e)) == 0)
             break;
-
         if (!__match_end(t, e))
             break;
-        if (rd < 0)
-            return err_val_result(cargv, name, "datetime", *a, rd);
-        if (rh < 0)
-            return err_val_result(cargv, name, "datetime", *a, rh);
-        if (rz < 0)
-            return err_val_result(cargv, name, "datetime", *a, rz);
+        if (r < 0)
+            return err_val_result(cargv, name, "geocoord", cur.i, a, e, r);
 
-        v->year = d.year;
-        v->month = d.month;
-        v->day = d.day;
-        v->hour = h.hour;
-        v->minute = h.minute;
-        v->second = h.second;
-        v->milisecond = h.milisecond;
-        memcpy(&v->tz, &tz, sizeof(v->tz));
+        lats[i] = cargv_get_degree(&g.latitude);
+        lons[i] = cargv_get_degree(&g.longitude);
+        ++i;
+        __cursor_next(&cur);
+    }
+    return i;
+}
 
-        ++a;
-        ++v;
+cargv_len_t cargv_geocoord_nano(
+    struct cargv_t *cargv,
+    const char *name,
+    cargv_int_t *lats, cargv_int_t *lons, cargv_len_t valc)
+{
+    int r;
+    _cursor cur;
+    _len i;
+    _geocoord g;
+    _str a, t, e;
+
+    __cursor_init(&cur, cargv);
+    i = 0;
+    while (i < valc && __cursor_get(&cur, &a, &e)) {
+        if ((r = __read_iso6709_geocoord(&g, &t, (t = a), e)) == 0)
+            break;
+        if (!__match_end(t, e))
+            break;
+        if (r < 0)
+            return err_val_result(cargv, name, "geocoord", cur.i, a, e, r);
+
+        lats[i] = cargv_get_nanodegree(&g.latitude);
+        lons[i] = cargv_get_nanodegree(&g.longitude);
+        ++i;
+        __cursor_next(&cur);
     }
-    return (int)(v-vals);
+    return i;
 }
 
-enum cargv_err_t cargv_local_datetime(
-    struct cargv_datetime_t *dst,
-    const struct cargv_datetime_t *src,
-    const struct cargv_timezone_t *tz)
+
+/* Parallel readers.
+
+Arguments are split into contiguous chunks, one per worker thread. Each
+worker reads its chunk straight into the output array and stops at its
+first failure, without any synchronization per value. Chunks are then
+examined in order, so that the first failure of the whole range decides
+the result, as serial readers do.
+*/
+#define _PARALLEL_MAX       64
+#define _PARALLEL_MIN_CHUNK 4096
+
+/* Read an argument into a value.
+
+[out] return: 1 if read, 0 if not matched, <0 if matched but wrong.
+[in/out] last: Zone of the last zone suffix read, per thread. See
+               __arg_zone_suffix().
+*/
+typedef int f_arg_read(
+    void *val, const struct cargv_zone_t **last, _str text, _str textend);
+
+typedef struct _chunk_t {
+    _str *args;
+    _len *lens;
+    f_arg_read *read;
+    char *vals;
+    size_t size;
+    const struct cargv_zone_t *last;    /* Of the chunk, for `read` */
+    _len begin, end;
+    _len stop;      /* Index of the first failure, or end */
+    int result;     /* Result of the failure */
+} _chunk;
+
+static void *__chunk_run(void *p)
 {
-    static const int days_of_month[] = {
-        0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
-    };
-    _sint year, month, day, hour, minute, tzh, tzm;
-
-    year = src->year;
-    month = src->month;
-    day = src->day;
-    hour = src->hour;
-    minute = src->minute;
-    tzh = -src->tz.hour + tz->hour;
-    tzm = -src->tz.minute + tz->minute;
-
-    hour += 24 + tzh;
-    minute += 60 + tzm;
-    hour += minute / 60 - 1;
-    if (day > 0) {  /* date included */
-        day += hour / 24 - 1;
-        if (day < 1) {
-            if (--month < 1) {
-                year -= 1;
-                if (year < -9999)
-                    return CARGV_VAL_OVERFLOW;
-                month = 12;
-            }
-            day = days_of_month[month] + __leap(year, (_uint)month);
+    _chunk *c = (_chunk *)p;
+    _len i;
+    _str a, e;
+    int r;
+
+    for (i = c->begin; i < c->end; ++i) {
+        a = c->args[i];
+        if (c->lens) {
+            if (c->lens[i] < 0)
+                c->lens[i] = (_len)strlen(a);
+            e = a + c->lens[i];
         }
-        else if (day > days_of_month[month] + __leap(year, (_uint)month)) {
-            if (++month > 12) {
-                year += 1;
-                if (year > 9999)
-                    return CARGV_VAL_OVERFLOW;
-                month = 1;
-            }
-            day = 1;
+        else
+            e = a + strlen(a);
+        if ((r = c->read(c->vals + (size_t)i * c->size, &c->last, a, e))
+            <= 0) {
+            c->stop = i;
+            c->result = r;
+            return NULL;
         }
     }
-    hour %= 24;
-    minute %= 60;
-
-    dst->year = year;
-    dst->month = month;
-    dst->day = day;
-    dst->hour = hour;
-    dst->minute = minute;
-    dst->second = src->second;
-    dst->milisecond = src->milisecond;
-    memcpy(&dst->tz, tz, sizeof(dst->tz));
-    return CARGV_OK;
+    c->stop = c->end;
+    c->result = 1;
+    return NULL;
 }
 
-
-int cargv_degree(
-    struct cargv_t *cargv,
-    const char *name,
-    struct cargv_degree_t *vals, cargv_len_t valc)
+/* Run the cursor of a serial reader, for sources without random access. */
+static _len __read_serial(
+    struct cargv_t *cargv, const char *name, const char *type,
+    f_arg_read *read, char *vals, size_t size, _len valc)
 {
+    const struct cargv_zone_t *last = NULL;
+    _cursor cur;
+    _len i;
+    _str a, e;
     int r;
-    _degree *v;
-    _str *a, t, e;
 
-    a = cargv->args;
-    v = vals;
-    while (a < cargv->argend && v - vals < valc) {
-        t = *a;
-        e = t + strlen(t);
-        if ((r = __read_iso6709_degree(v, &t, t, e)) == 0)
-            break;
-        if (!__match_end(t, e))
+    __cursor_init(&cur, cargv);
+    for (i = 0; i < valc && __cursor_get(&cur, &a, &e); ++i) {
+        if ((r = read(vals + (size_t)i * size, &last, a, e)) == 0)
             break;
         if (r < 0)
-            return err_val_result(cargv, name, "degree", *a, r);
+            return err_val_result(cargv, name, type, cur.i, a, e, r);
+        __cursor_next(&cur);
+    }
+    return i;
+}
 
-        ++v;
-        ++a;
+static int __parallel_threads(int threads)
+{
+#ifdef _HAVE_PTHREAD
+    long n;
+
+    if (threads <= 0)
+        threads = ((n = sysconf(_SC_NPROCESSORS_ONLN)) > 0) ? (int)n : 1;
+#else
+    threads = 1;
+#endif
+    return (threads < _PARALLEL_MAX) ? threads : _PARALLEL_MAX;
+}
+
+static _len __read_parallel(
+    struct cargv_t *cargv, const char *name, const char *type,
+    f_arg_read *read, void *vals, size_t size, _len valc, int threads)
+{
+    _chunk chunks[_PARALLEL_MAX];
+#ifdef _HAVE_PTHREAD
+    pthread_t tids[_PARALLEL_MAX];
+    int started[_PARALLEL_MAX];
+#endif
+    _len n, per, i;
+    _chunk *c;
+    _str a;
+    int k;
+
+    if (cargv->buf)
+        return __read_serial(
+            cargv, name, type, read, (char *)vals, size, valc);
+
+    n = cargv->argend - cargv->args;
+    if (n > valc)
+        n = valc;
+    if (n <= 0)
+        return 0;
+
+    threads = __parallel_threads(threads);
+    if (threads > (n + _PARALLEL_MIN_CHUNK - 1) / _PARALLEL_MIN_CHUNK)
+        threads = (int)((n + _PARALLEL_MIN_CHUNK - 1) / _PARALLEL_MIN_CHUNK);
+    if (threads < 1)
+        threads = 1;
+    per = (n + threads - 1) / threads;
+
+    for (k = 0; k < threads; ++k) {
+        c = &chunks[k];
+        c->args = cargv->args;
+        c->lens = cargv->lens;
+        c->read = read;
+        c->vals = (char *)vals;
+        c->size = size;
+        c->last = NULL;
+        c->begin = (_len)k * per;
+        c->end = (c->begin + per < n) ? c->begin + per : n;
+        if (c->begin > c->end)
+            c->begin = c->end;
+    }
+
+    /* The caller thread takes the first chunk. */
+#ifdef _HAVE_PTHREAD
+    for (k = 1; k < threads; ++k)
+        started[k] = pthread_create(&tids[k], NULL, __chunk_run, &chunks[k])
+                     == 0;
+#endif
+    __chunk_run(&chunks[0]);
+    for (k = 1; k < threads; ++k) {
+#ifdef _HAVE_PTHREAD
+        if (started[k]) {
+            pthread_join(tids[k], NULL);
+            continue;
+        }
+#endif
+        __chunk_run(&chunks[k]);
+    }
+
+    for (k = 0; k < threads; ++k) {
+        c = &chunks[k];
+        if (c->stop < c->end) {
+            i = c->stop;
+            if (c->result == 0)
+                return i;
+            a = cargv->args[i];
+            return err_val_result(cargv, name, type, i,
+                a, a + (cargv->lens ? cargv->lens[i] : (_len)strlen(a)),
+                c->result);
+        }
     }
-    return (int)(v-vals);
+    return n;
+}
+
+static int __arg_int(
+    void *val, const struct cargv_zone_t **last, _str text, _str textend)
+{
+    int r;
+    _str t;
+    (void)last;
+
+    if ((r = __read_sint_dec((_sint *)val, &t, text, textend)) == 0
+        || !__match_end(t, textend))
+        return 0;
+    return (r < 0) ? r : 1;
+}
+
+static int __arg_datetime_value(
+    void *val, const struct cargv_zone_t **last, _str text, _str textend)
+{
+    int r;
+    _datetime *v = (_datetime *)val;
+    _ymd d;
+    _hms h;
+    _tz tz;
+
+    if ((r = __zoned_datetime(NULL, CARGV_FORMAT_ANY, _FMT_DATE|_FMT_TIME,
+                              last, &d, &h, &tz, text, textend)) <= 0)
+        return r;
+
+    v->year = d.year;
+    v->month = d.month;
+    v->day = d.day;
+    v->hour = h.hour;
+    v->minute = h.minute;
+    v->second = h.second;
+    v->milisecond = h.milisecond;
+    memcpy(&v->tz, &tz, sizeof(v->tz));
+    return 1;
+}
+
+static int __arg_geocoord(
+    void *val, const struct cargv_zone_t **last, _str text, _str textend)
+{
+    int r;
+    _str t;
+    (void)last;
+
+    if ((r = __read_iso6709_geocoord(
+            (_geocoord *)val, &t, (t = text), textend)) == 0
+        || !__match_end(t, textend))
+        return 0;
+    return (r < 0) ? r : 1;
 }
 
-int cargv_geocoord(
+cargv_len_t cargv_int_parallel(
     struct cargv_t *cargv,
     const char *name,
-    struct cargv_geocoord_t *vals, cargv_len_t valc)
+    cargv_int_t *vals, cargv_len_t valc,
+    int threads)
 {
-    int r;
-    _geocoord *v;
-    _str *a, t, e;
+    return __read_parallel(cargv, name, "integer", __arg_int,
+                           vals, sizeof(*vals), valc, threads);
+}
 
-    a = cargv->args;
-    v = vals;
-    while (a < cargv->argend && v - vals < valc) {
-        t = *a;
-        e = t + strlen(t);
-        if ((r = __read_iso6709_geocoord(v, &t, t, e)) == 0)
-            break;
-        if (!__match_end(t, e))
-            break;
-        if (r < 0)
-            return err_val_result(cargv, name, "geocoord", *a, r);
+cargv_len_t cargv_datetime_parallel(
+    struct cargv_t *cargv,
+    const char *name,
+    struct cargv_datetime_t *vals, cargv_len_t valc,
+    int threads)
+{
+    return __read_parallel(cargv, name, "datetime", __arg_datetime_value,
+                           vals, sizeof(*vals), valc, threads);
+}
 
-        ++v;
-        ++a;
+cargv_len_t cargv_geocoord_parallel(
+    struct cargv_t *cargv,
+    const char *name,
+    struct cargv_geocoord_t *vals, cargv_len_t valc,
+    int threads)
+{
+    return __read_parallel(cargv, name, "geocoord", __arg_geocoord,
+                           vals, sizeof(*vals), valc, threads);
+}
+
+/* Option map of all specs, for cargv_dispatch().
+
+Maps short option characters and long option names to specs, index+1.
+0 means no spec.
+*/
+#define _OPTMAP_SLOTS     (CARGV_DISPATCH_LONG_MAX * 2)
+#define _OPTMAP_SLOT_MASK (_OPTMAP_SLOTS - 1)
+#define _OPTMAP_SPEC_MAX  0xFFFE
+
+typedef struct _optmap_t {
+    unsigned short shorts[256];
+    _str longs[CARGV_DISPATCH_LONG_MAX];
+    _len longlens[CARGV_DISPATCH_LONG_MAX];
+    unsigned short longspecs[CARGV_DISPATCH_LONG_MAX];
+    unsigned short slots[_OPTMAP_SLOTS];    /* longs, index+1 */
+    int longc;
+    unsigned short wildcard;
+} _optmap;
+
+static int __optmap_long(const _optmap *m, _str text, _str textend)
+{
+    _len len = textend - text;
+    unsigned h = __opt_hash(text, len);
+    int i;
+
+    while ((i = m->slots[h & _OPTMAP_SLOT_MASK]) != 0) {
+        --i;
+        if (m->longlens[i] == len
+            && memcmp(m->longs[i], text, (size_t)len) == 0)
+            return m->longspecs[i];
+        ++h;
     }
-    return (int)(v-vals);
+    return 0;
 }
 
-_real cargv_get_degree(const struct cargv_degree_t *val)
+static enum cargv_err_t __optmap_init(
+    _optmap *m, const struct cargv_spec_t *specs, _len specc)
 {
-    return (_real)val->degree + (_real)val->microdegree / 1E+6
-        + ((_real)val->minute + (_real)val->microminute / 1E+6) / 60.0
-        + ((_real)val->second + (_real)val->microsecond / 1E+6) / 3600.0;
+    _str optlist, oend, o, lopt, shorts, shortend, name, nameend;
+    unsigned short i;
+    unsigned h;
+
+    if (specc < 0 || specc > _OPTMAP_SPEC_MAX)
+        return CARGV_BAD_PARAM;
+
+    memset(m->shorts, 0, sizeof(m->shorts));
+    memset(m->slots, 0, sizeof(m->slots));
+    m->longc = 0;
+    m->wildcard = 0;
+
+    for (i = 1; i <= specc; ++i) {
+        if (!(optlist = specs[i-1].optlist))
+            continue;
+        oend = optlist + strlen(optlist);
+
+        o = optlist;
+        if (__match_str(&o, o, oend, "-", 1)
+            && __match_str(&o, o, oend, "*", 1)
+            && __match_end(o, oend)) {
+            if (!m->wildcard)
+                m->wildcard = i;
+            continue;
+        }
+
+        __optlist_split(&lopt, &shorts, &shortend, optlist, oend);
+        for (o = shorts; o < shortend; ++o) {
+            if (!m->shorts[(unsigned char)*o])
+                m->shorts[(unsigned char)*o] = i;
+        }
+
+        o = lopt;
+        while (__optlist_next_long(&o, &name, &nameend, oend)) {
+            if (!(nameend > name) || __optmap_long(m, name, nameend))
+                continue;   /* `--`, or taken by a former spec */
+            if (!(m->longc < CARGV_DISPATCH_LONG_MAX))
+                return CARGV_NO_MEMORY;
+
+            h = __opt_hash(name, nameend - name);
+            while (m->slots[h & _OPTMAP_SLOT_MASK])
+                ++h;
+            m->slots[h & _OPTMAP_SLOT_MASK] = (unsigned short)(m->longc + 1);
+            m->longs[m->longc] = name;
+            m->longlens[m->longc] = nameend - name;
+            m->longspecs[m->longc] = i;
+            ++m->longc;
+        }
+    }
+    return CARGV_OK;
+}
+
+/* Read one value of a spec from the first argument.
+
+[out] return: 1 if read, 0 if not matched, <0 if error.
+*/
+static _len __dispatch_value(
+    struct cargv_t *cargv, struct cargv_spec_t *spec)
+{
+    _len i = spec->count;
+    _str name = spec->name ? spec->name : spec->optlist;
+
+    if (!(i < spec->valc))
+        return 0;   /* no more room */
+
+    switch (spec->type) {
+    case CARGV_TEXT:
+        return cargv_text(cargv, name, (_str *)spec->vals + i, 1);
+    case CARGV_ONEOF:
+        return cargv_oneof(cargv, name, spec->list, spec->sep,
+            (_str *)spec->vals + i, 1);
+    case CARGV_INT:
+        return cargv_int(cargv, name, (_sint *)spec->vals + i, 1);
+    case CARGV_UINT:
+        return cargv_uint(cargv, name, (_uint *)spec->vals + i, 1);
+    case CARGV_DATE:
+        return cargv_date(cargv, name, (_datetime *)spec->vals + i, 1);
+    case CARGV_TIME:
+        return cargv_time(cargv, name, (_datetime *)spec->vals + i, 1);
+    case CARGV_TIMEZONE:
+        return cargv_timezone(cargv, name, (_tz *)spec->vals + i, 1);
+    case CARGV_DATETIME:
+        return cargv_datetime(cargv, name, (_datetime *)spec->vals + i, 1);
+    case CARGV_DEGREE:
+        return cargv_degree(cargv, name, (_degree *)spec->vals + i, 1);
+    case CARGV_GEOCOORD:
+        return cargv_geocoord(cargv, name, (_geocoord *)spec->vals + i, 1);
+    default:
+        return 0;
+    }
+}
+
+cargv_len_t cargv_dispatch(
+    struct cargv_t *cargv,
+    struct cargv_spec_t *specs, cargv_len_t specc)
+{
+    _optmap m;
+    struct cargv_t peek;
+    struct cargv_spec_t *spec, *pos;
+    _cursor cur;
+    _str a, aend, t;
+    _len n, r, i, len;
+    unsigned short hits[256];
+    int hitc, optend;
+    enum cargv_err_t err;
+
+    if ((err = __optmap_init(&m, specs, specc)) < 0)
+        return err;
+    for (spec = specs; spec < specs + specc; ++spec)
+        spec->count = 0;
+
+    n = 0;
+    optend = 0;
+    pos = specs;
+    for (;;) {
+        __cursor_init(&cur, cargv);
+        if (!__cursor_get(&cur, &a, &aend))
+            break;
+
+        /* Classify: find specs of options in the argument */
+        hitc = 0;
+        t = a;
+        if (optend)
+            ;
+        else if (__match_str(&t, t, aend, "--", 2)) {
+            if (__match_end(t, aend)) {
+                optend = 1;     /* -- */
+                if ((r = cargv_shift(cargv, 1)) < 0)
+                    return r;
+                ++n;
+                continue;
+            }
+            if ((hits[0] = (unsigned short)__optmap_long(&m, t, aend)) != 0
+                || (hits[0] = m.wildcard) != 0)
+                hitc = 1;
+            else
+                break;  /* unknown option */
+        }
+        else if (__match_str(&t, t, aend, "-", 1) && !__match_end(t, aend)) {
+            for (; t < aend && hitc < 256; ++t) {
+                if (!(hits[hitc++] = m.shorts[(unsigned char)*t]))
+                    break;
+            }
+            if (!(t == aend && hits[hitc-1])) {
+                if ((hits[0] = m.wildcard) != 0)
+                    hitc = 1;
+                else if (__char_is(a[1], _CC_DIGIT))
+                    hitc = 0;   /* negative number */
+                else
+                    break;  /* unknown option */
+            }
+        }
+
+        /* Options, and their values following. They are read on a copy of
+           cargv, over arguments in the buffer or the stream window only, and
+           taken only if all succeeded. */
+        if (hitc > 0) {
+            memcpy(&peek, cargv, sizeof(peek));
+            peek.fd = -1;   /* shifts in the window, without reading */
+            cargv_shift(&peek, 1);
+            for (r = 1, i = 0; i < hitc; ++i) {
+                spec = specs + hits[i] - 1;
+                if (spec->type != CARGV_FLAG) {
+                    if ((r = __dispatch_value(&peek, spec)) <= 0)
+                        break;
+                    cargv_shift(&peek, 1);
+                }
+                ++spec->count;
+            }
+            if (i < hitc) {
+                while (i-- > 0)
+                    --specs[hits[i] - 1].count;
+                if (r < 0)
+                    return r;
+
+                /* Values may be in the stream past the window. */
+                len = cargv_len(cargv);
+                if (cargv_len(&peek) == 0
+                    && (r = __stream_fill(cargv, len + 1)) < 0)
+                    return r;
+                if (cargv_len(cargv) > len)
+                    continue;
+                break;  /* missing value */
+            }
+            n += peek.argi - cargv->argi;
+            peek.fd = cargv->fd;
+            memcpy(cargv, &peek, sizeof(*cargv));
+            if ((r = __stream_fill(cargv, 1)) < 0)
+                return r;
+            continue;
+        }
+
+        /* Positional values */
+        while (pos < specs + specc
+               && (pos->optlist || pos->type == CARGV_FLAG
+                   || !(pos->count < pos->valc)))
+            ++pos;
+        if (!(pos < specs + specc))
+            break;  /* no room */
+        if ((r = __dispatch_value(cargv, pos)) < 0)
+            return r;
+        if (r == 0)
+            break;  /* not matched */
+        ++pos->count;
+        if ((r = cargv_shift(cargv, 1)) < 0)
+            return r;
+        ++n;
+    }
+    return n;
 }
@@ -0,0 +1,16 @@
+/* Compile check of the single header after <linux/types.h>, which takes
+names like __be32 that the implementation must not use. Built by
+`scons single`. */
+#include <linux/types.h>
+
+#define CARGV_IMPLEMENTATION
+#include "cargv.h"
+
+int main(int argc, const char **argv)
+{
+    struct cargv_t cargv;
+
+    if (cargv_init(&cargv, argv[0], argc, argv) != CARGV_OK)
+        return 1;
+    return (int)cargv_shift(&cargv, 1) != 1;
+}
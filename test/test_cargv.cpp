@@ -7,6 +7,14 @@
 #include <math.h>
 #include <time.h>
 
+#ifndef _WIN32
+  #include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
 
 
 #define _c(a)    (ptrdiff_t(sizeof(a)/sizeof((a)[0])))
@@ -73,6 +81,62 @@ TEST_F(Test_cargv, opt)
     EXPECT_EQ(cargv_shift(&cargv, 1), 0);
 }
 
+TEST_F(Test_cargv, optset)
+{
+    static const char *args[] = { _name,
+        "-h", "-xvf", "-xvfxh", "--help", "--helpme", "--verbose", "-", "--",
+        "text",
+    };
+    static const int expected[] = { 1, 1, 0, 1, 0, 1, 0, 0, 0, };
+    const int *e = expected;
+    cargv_optset_t optset, any;
+
+    ASSERT_EQ(_c(args)-1, _c(expected));
+    ASSERT_EQ(cargv_optset_init(&optset, "-hvxf--help--me--verbose"), CARGV_OK);
+    ASSERT_EQ(cargv_optset_init(&any, "-*"), CARGV_OK);
+    ASSERT_EQ(cargv_init(&cargv, _name, _c(args), args), CARGV_OK);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    while (cargv_len(&cargv) > 0) {
+        EXPECT_EQ(cargv_optset(&cargv, &optset), *e);
+        EXPECT_EQ(cargv_opt(&cargv, "-hvxf--help--me--verbose"), *e);
+        EXPECT_EQ(cargv_optset(&cargv, &any), cargv_opt(&cargv, "-*"));
+        EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+        ++e;
+    }
+}
+
+TEST_F(Test_cargv, optset_overflow)
+{
+    char optlist[(CARGV_OPTSET_LONG_MAX+1)*5+1];
+    cargv_optset_t optset;
+
+    for (int i = 0; i <= CARGV_OPTSET_LONG_MAX; ++i)
+        snprintf(optlist+i*5, 6, "--%03d", i);
+    ASSERT_EQ(cargv_optset_init(&optset, optlist), CARGV_NO_MEMORY);
+    optlist[CARGV_OPTSET_LONG_MAX*5] = '\0';
+    ASSERT_EQ(cargv_optset_init(&optset, optlist), CARGV_OK);
+    EXPECT_EQ(optset.longc, CARGV_OPTSET_LONG_MAX);
+
+    static const char *args[] = { "--000", "--063", "--064", "--06", };
+    ASSERT_EQ(cargv_init(&cargv, _name, _c(args), args), CARGV_OK);
+    EXPECT_EQ(cargv_optset(&cargv, &optset), 1);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    EXPECT_EQ(cargv_optset(&cargv, &optset), 1);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    EXPECT_EQ(cargv_optset(&cargv, &optset), 0);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    EXPECT_EQ(cargv_optset(&cargv, &optset), 0);
+
+    // cargv_opt() takes lists of any length
+    optlist[CARGV_OPTSET_LONG_MAX*5] = '-';
+    ASSERT_EQ(cargv_init(&cargv, _name, _c(args), args), CARGV_OK);
+    EXPECT_EQ(cargv_opt(&cargv, optlist), 1);
+    EXPECT_EQ(cargv_shift(&cargv, 2), 2);
+    EXPECT_EQ(cargv_opt(&cargv, optlist), 1);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    EXPECT_EQ(cargv_opt(&cargv, optlist), 0);
+}
+
 TEST_F(Test_cargv, opt_empty)
 {
     static const char *args[] = { _name, "-", "--", };
@@ -88,6 +152,383 @@ TEST_F(Test_cargv, opt_empty)
     EXPECT_EQ(cargv_shift(&cargv, 1), 0);
 }
 
+TEST_F(Test_cargv, lens)
+{
+    static const char *args[] = { _name, "-h", "123", "2019-06-03", "4567", };
+    cargv_len_t lens[] = { -1, -1, -1, -1, 2, };
+    cargv_int_t n[2];
+    cargv_datetime_t d;
+
+    ASSERT_EQ(cargv_init_lens(&cargv, _name, _c(args), args, lens), CARGV_OK);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    EXPECT_EQ(lens[0], -1);
+    EXPECT_EQ(cargv_opt(&cargv, "-h"), 1);
+    EXPECT_EQ(lens[1], 2);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    EXPECT_EQ(cargv_int(&cargv, "TEST", n, 1), 1);
+    EXPECT_EQ(n[0], 123);
+    EXPECT_EQ(lens[2], 3);
+    EXPECT_EQ(lens[3], -1);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    EXPECT_EQ(cargv_date(&cargv, "TEST", &d, 1), 1);
+    EXPECT_EQ(d.day, 3);
+    EXPECT_EQ(lens[3], 10);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    EXPECT_EQ(cargv_int(&cargv, "TEST", n, 2), 1);
+    EXPECT_EQ(n[0], 45);    // Given length wins
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 0);
+}
+
+TEST_F(Test_cargv, buffer)
+{
+    static const char buf[] = "a\n\nbc\n-h\n";
+    const char *t[4];
+
+    ASSERT_EQ(cargv_init_buffer(&cargv, _name, buf, _c(buf)-1, '\n'),
+              CARGV_OK);
+    EXPECT_EQ(cargv_len(&cargv), 4);
+    EXPECT_EQ(cargv_text(&cargv, "TEST", t, 4), 4);
+    EXPECT_EQ(t[0], buf+0);
+    EXPECT_EQ(t[1], buf+2);
+    EXPECT_EQ(t[2], buf+3);
+    EXPECT_EQ(t[3], buf+6);
+    EXPECT_EQ(cargv_opt(&cargv, "-h"), 0);
+    EXPECT_EQ(cargv_shift(&cargv, 5), 0);
+    EXPECT_EQ(cargv_shift(&cargv, 3), 3);
+    EXPECT_EQ(cargv_len(&cargv), 1);
+    EXPECT_EQ(cargv_opt(&cargv, "-h"), 1);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    EXPECT_EQ(cargv_len(&cargv), 0);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 0);
+
+    // No delimiter at the end
+    ASSERT_EQ(cargv_init_buffer(&cargv, _name, buf, 4, '\n'), CARGV_OK);
+    EXPECT_EQ(cargv_len(&cargv), 3);
+    ASSERT_EQ(cargv_init_buffer(&cargv, _name, buf, 0, '\n'), CARGV_OK);
+    EXPECT_EQ(cargv_len(&cargv), 0);
+    EXPECT_EQ(cargv_init_buffer(&cargv, _name, buf, -1, '\n'),
+              CARGV_BAD_PARAM);
+}
+
+TEST_F(Test_cargv, buffer_int)
+{
+    static const char buf[] =
+        "1,000,000 -2 3 +4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20 x 21";
+    cargv_int_t v[32];
+
+    ASSERT_EQ(cargv_init_buffer(&cargv, _name, buf, _c(buf)-1, ' '),
+              CARGV_OK);
+    EXPECT_EQ(cargv_len(&cargv), 22);
+    EXPECT_EQ(cargv_int(&cargv, "TEST", v, _c(v)), 20);
+    EXPECT_EQ(v[0], 1000000);
+    EXPECT_EQ(v[1], -2);
+    EXPECT_EQ(v[19], 20);
+    EXPECT_EQ(cargv_shift(&cargv, 20), 20);
+    EXPECT_EQ(cargv_int(&cargv, "TEST", v, _c(v)), 0);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    EXPECT_EQ(cargv_int(&cargv, "TEST", v, _c(v)), 1);
+    EXPECT_EQ(v[0], 21);
+
+    static const char overflow[] = "1\n9223372036854775808\n";
+    ASSERT_EQ(cargv_init_buffer(&cargv, _name, overflow, _c(overflow)-1, '\n'),
+              CARGV_OK);
+    testing::internal::CaptureStderr();
+    EXPECT_EQ(cargv_int(&cargv, "TEST", v, _c(v)), CARGV_VAL_OVERFLOW);
+    EXPECT_EQ(testing::internal::GetCapturedStderr(),
+        "cargv-test: integer `TEST` overflows, which is "
+        "`9223372036854775808`.\n");
+}
+
+TEST_F(Test_cargv, buffer_datetime)
+{
+    static const char buf[] =
+        "2019-06-03T08:00+9:30\0" "--02-03 24:00-1\0" "23:59:59";
+    cargv_datetime_t v[4];
+
+    ASSERT_EQ(cargv_init_buffer(&cargv, _name, buf, _c(buf)-1, '\0'),
+              CARGV_OK);
+    EXPECT_EQ(cargv_len(&cargv), 3);
+    EXPECT_EQ(cargv_datetime(&cargv, "TEST", v, _c(v)), 3);
+    EXPECT_EQ(v[0].year, 2019);
+    EXPECT_EQ(v[0].tz.minute, 30);
+    EXPECT_EQ(v[1].month, 2);
+    EXPECT_EQ(v[1].tz.hour, -1);
+    EXPECT_EQ(v[2].second, 59);
+    EXPECT_EQ(v[2].tz.hour, CARGV_TZ_HOUR_DEFAULT);
+}
+
+#ifndef _WIN32
+TEST_F(Test_cargv, stream)
+{
+    static const char data[] =
+        "1\n22\n333\n2019-06-03\n-4444\nabcdefghijklmn\n55";
+    int fds[2];
+    char win[12];
+    cargv_int_t v[4];
+    cargv_datetime_t d;
+    const char *t;
+
+    ASSERT_EQ(pipe(fds), 0);
+    ASSERT_EQ(write(fds[1], data, sizeof(data)-1), (ssize_t)sizeof(data)-1);
+    close(fds[1]);
+
+    ASSERT_EQ(cargv_init_fd(&cargv, _name, fds[0], '\n', win, _c(win)),
+              CARGV_OK);
+    EXPECT_EQ(cargv_len(&cargv), 3);
+    EXPECT_EQ(cargv_int(&cargv, "TEST", v, _c(v)), 3);
+    EXPECT_EQ(v[2], 333);
+    EXPECT_EQ(cargv_shift(&cargv, 3), 3);
+    EXPECT_EQ(cargv_date(&cargv, "TEST", &d, 1), 1);  // Crossed chunks
+    EXPECT_EQ(d.year, 2019);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    EXPECT_EQ(cargv_int(&cargv, "TEST", v, 1), 1);
+    EXPECT_EQ(v[0], -4444);
+    EXPECT_EQ(cargv_shift(&cargv, 1), CARGV_NO_MEMORY);  // Over the window
+    EXPECT_EQ(cargv_len(&cargv), 0);
+    EXPECT_EQ(cargv_text(&cargv, "TEST", &t, 1), 0);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 0);
+    close(fds[0]);
+}
+
+TEST_F(Test_cargv, stream_shift)
+{
+    static const char data[] = "1\n2\n3\n4\n5\n6\n7";
+    int fds[2];
+    char win[6];
+    cargv_int_t v[4];
+
+    ASSERT_EQ(pipe(fds), 0);
+    ASSERT_EQ(write(fds[1], data, sizeof(data)-1), (ssize_t)sizeof(data)-1);
+    close(fds[1]);
+
+    // All or nothing, up to the window
+    ASSERT_EQ(cargv_init_fd(&cargv, _name, fds[0], '\n', win, _c(win)),
+              CARGV_OK);
+    EXPECT_EQ(cargv_len(&cargv), 3);
+    EXPECT_EQ(cargv_shift(&cargv, 4), 0);
+    EXPECT_EQ(cargv_len(&cargv), 3);
+    EXPECT_EQ(cargv_int(&cargv, "TEST", v, 1), 1);
+    EXPECT_EQ(v[0], 1);
+    EXPECT_EQ(cargv_shift(&cargv, 2), 2);
+    EXPECT_EQ(cargv_len(&cargv), 1);
+    EXPECT_EQ(cargv_shift(&cargv, 3), 3);   // Read more first
+    EXPECT_EQ(cargv_int(&cargv, "TEST", v, _c(v)), 1);
+    EXPECT_EQ(v[0], 6);
+    EXPECT_EQ(cargv_shift(&cargv, 3), 0);
+    EXPECT_EQ(cargv_len(&cargv), 2);
+    EXPECT_EQ(cargv_shift(&cargv, 2), 2);
+    EXPECT_EQ(cargv_len(&cargv), 0);
+    close(fds[0]);
+
+    // Read error, from the write end of a pipe
+    ASSERT_EQ(pipe(fds), 0);
+    EXPECT_EQ(cargv_init_fd(&cargv, _name, fds[1], '\n', win, _c(win)),
+              CARGV_IO_ERROR);
+    EXPECT_EQ(cargv_len(&cargv), 0);
+    close(fds[0]);
+    close(fds[1]);
+}
+#endif
+
+static std::string _write_file(const char *name, const char *text)
+{
+    std::string path = testing::TempDir() + name;
+    FILE *f = fopen(path.c_str(), "wb");
+    fputs(text, f);
+    fclose(f);
+    return path;
+}
+
+TEST_F(Test_cargv, expand)
+{
+    std::string inner = _write_file("cargv_inner.rsp", "7 '@not file'\n");
+    std::string outer = _write_file("cargv_outer.rsp",
+        ("-n 1\t\"a b\"\n  @" + inner + "\r\n2019-06-03 ").c_str());
+    std::string empty = _write_file("cargv_empty.rsp", "");
+    std::string at_outer = "@" + outer, at_empty = "@" + empty;
+    const char *args[] = { _name, at_outer.c_str(), at_empty.c_str(), "@" };
+    cargv_expand_t exp;
+    cargv_int_t v[2];
+    cargv_datetime_t d;
+    const char *t;
+
+    ASSERT_EQ(cargv_init_expand(&cargv, _name, _c(args), args, &exp,
+                                CARGV_EXPAND_DEPTH, NULL), CARGV_OK);
+    EXPECT_EQ(cargv_len(&cargv), 8);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    EXPECT_EQ(cargv_opt(&cargv, "-n"), 1);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    EXPECT_EQ(cargv_int(&cargv, "TEST", v, 1), 1);
+    EXPECT_EQ(v[0], 1);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    EXPECT_EQ(cargv_text(&cargv, "TEST", &t, 1), 1);
+    EXPECT_EQ(std::string(t, (size_t)exp.lens[3]), "a b");
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    EXPECT_EQ(cargv_int(&cargv, "TEST", v, 2), 1);
+    EXPECT_EQ(v[0], 7);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    EXPECT_EQ(exp.lens[5], 9);  // `@not file` is not expanded
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    EXPECT_EQ(cargv_date(&cargv, "TEST", &d, 1), 1);
+    EXPECT_EQ(d.day, 3);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    EXPECT_EQ(cargv_text(&cargv, "TEST", &t, 1), 1);
+    EXPECT_STREQ(t, "@");
+    cargv_expand_release(&exp);
+
+    ASSERT_EQ(cargv_init_expand(&cargv, _name, _c(args), args, &exp, 1, NULL),
+              CARGV_NO_MEMORY);
+    cargv_expand_release(&exp);
+    ASSERT_EQ(cargv_init_expand(&cargv, _name, _c(args), args, &exp, 0, NULL),
+              CARGV_OK);
+    EXPECT_EQ(cargv_len(&cargv), _c(args));
+    cargv_expand_release(&exp);
+
+    std::string bad = _write_file("cargv_bad.rsp", "'open");
+    std::string at_bad = "@" + bad;
+    const char *bads[] = { _name, at_bad.c_str(), };
+    ASSERT_EQ(cargv_init_expand(&cargv, _name, _c(bads), bads, &exp, 1, NULL),
+              CARGV_BAD_PARAM);
+    cargv_expand_release(&exp);
+    bads[1] = "@/nonexistent/cargv.rsp";
+    ASSERT_EQ(cargv_init_expand(&cargv, _name, _c(bads), bads, &exp, 1, NULL),
+              CARGV_IO_ERROR);
+    cargv_expand_release(&exp);
+}
+
+TEST_F(Test_cargv, arena)
+{
+    alignas(16) char mem[256];
+    cargv_arena_t arena;
+    cargv_error_sink_t sink;
+    cargv_int_t v[3];
+    char *p, *q, *big;
+    int i;
+
+    cargv_arena_init(&arena, mem, sizeof(mem), 1024);
+    p = (char *)cargv_arena_alloc(&arena, 1);
+    q = (char *)cargv_arena_alloc(&arena, 100);
+    EXPECT_EQ(p, mem);
+    EXPECT_EQ(q, mem + 16);
+    EXPECT_EQ(arena.blocks, nullptr);
+
+    big = (char *)cargv_arena_alloc(&arena, 4000);  // Own block
+    ASSERT_NE(big, nullptr);
+    EXPECT_EQ((uintptr_t)big % 16, 0u);
+    memset(big, 1, 4000);
+    EXPECT_EQ(cargv_arena_alloc(&arena, 16), mem + 128);
+
+    for (i = 0; i < 100; ++i) {
+        p = (char *)cargv_arena_alloc(&arena, 24);
+        ASSERT_NE(p, nullptr);
+        EXPECT_EQ((uintptr_t)p % 16, 0u);
+        memset(p, 2, 24);
+    }
+    EXPECT_NE(arena.blocks, nullptr);
+    EXPECT_EQ(cargv_arena_alloc(&arena, -1), nullptr);
+
+    cargv_arena_release(&arena);
+    EXPECT_EQ(arena.blocks, nullptr);
+    EXPECT_EQ(cargv_arena_alloc(&arena, 1), mem);
+    cargv_arena_release(&arena);
+
+    // Expanded arguments and errors of a session, in one arena
+    std::string rsp = _write_file("cargv_arena.rsp",
+                                  "1 x 99999999999999999999");
+    std::string at_rsp = "@" + rsp;
+    const char *args[] = { at_rsp.c_str(), };
+    cargv_expand_t exp;
+
+    cargv_arena_init(&arena, NULL, 0, 0);
+    ASSERT_EQ(cargv_init_expand(&cargv, _name, _c(args), args, &exp,
+                                CARGV_EXPAND_DEPTH, &arena), CARGV_OK);
+    EXPECT_EQ(cargv.arena, &arena);
+    EXPECT_EQ(cargv_len(&cargv), 3);
+    ASSERT_EQ(cargv_error_sink_alloc(&sink, &cargv, 4), CARGV_OK);
+    EXPECT_EQ(cargv_int(&cargv, "TEST", v, _c(v)), 1);
+    EXPECT_EQ(cargv_shift(&cargv, 2), 2);
+    EXPECT_EQ(cargv_int(&cargv, "TEST", v, _c(v)), CARGV_VAL_OVERFLOW);
+    ASSERT_EQ(sink.count, 1);
+    EXPECT_EQ(cargv_error_at(&sink, 0)->code, CARGV_VAL_OVERFLOW);
+    cargv_expand_release(&exp);
+    cargv_arena_release(&arena);
+
+    cargv_set_arena(&cargv, NULL);
+    EXPECT_EQ(cargv_error_sink_alloc(&sink, &cargv, 4), CARGV_BAD_PARAM);
+}
+
+static void _count_error(void *ctx, const cargv_error_t *err)
+{
+    *(cargv_len_t *)ctx += err->index;
+}
+
+TEST_F(Test_cargv, error_sink)
+{
+    static const char *args[] = { _name,
+        "1", "99999999999999999999", "2019-13-01", "-99999999999999999999",
+    };
+    cargv_error_t ring[2];
+    cargv_error_sink_t sink;
+    cargv_int_t v;
+    cargv_datetime_t d;
+    char msg[128];
+
+    ASSERT_EQ(cargv_init(&cargv, _name, _c(args), args), CARGV_OK);
+    cargv_error_sink_ring(&sink, ring, _c(ring));
+    cargv_set_error_sink(&cargv, &sink);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    testing::internal::CaptureStderr();
+    EXPECT_EQ(cargv_int(&cargv, "TEST", &v, 2), CARGV_VAL_OVERFLOW);
+    EXPECT_EQ(cargv_shift(&cargv, 2), 2);
+    EXPECT_EQ(cargv_date(&cargv, "DATE", &d, 1), CARGV_VAL_OVERFLOW);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    EXPECT_EQ(cargv_int(&cargv, "TEST", &v, 1), CARGV_VAL_OVERFLOW);
+    EXPECT_EQ(testing::internal::GetCapturedStderr(), "");
+
+    EXPECT_EQ(sink.count, 3);
+    ASSERT_NE(cargv_error_at(&sink, 0), nullptr);
+    EXPECT_EQ(cargv_error_at(&sink, 0)->index, 3);
+    EXPECT_EQ(cargv_error_at(&sink, 0)->offset, -1);
+    EXPECT_STREQ(cargv_error_at(&sink, 0)->type, "date");
+    EXPECT_EQ(cargv_error_at(&sink, 1)->index, 4);
+    EXPECT_EQ(cargv_error_at(&sink, 1)->code, CARGV_VAL_OVERFLOW);
+    EXPECT_EQ(cargv_error_at(&sink, 2), nullptr);
+    EXPECT_EQ(cargv_format_error(msg, _c(msg), &cargv,
+                                 cargv_error_at(&sink, 0)), 58);
+    EXPECT_STREQ(msg, "cargv-test: date `DATE` overflows, "
+                      "which is `2019-13-01`.\n");
+
+    static const char buf[] = "1\n99999999999999999999\n2";
+    cargv_len_t sum = 0;
+
+    ASSERT_EQ(cargv_init_buffer(&cargv, _name, buf, _c(buf)-1, '\n'),
+              CARGV_OK);
+    cargv_error_sink_callback(&sink, _count_error, &sum);
+    cargv_set_error_sink(&cargv, &sink);
+    EXPECT_EQ(cargv_int(&cargv, "TEST", &v, 3), CARGV_VAL_OVERFLOW);
+    EXPECT_EQ(sum, 1);
+    EXPECT_EQ(sink.count, 1);
+
+    cargv_error_sink_ring(&sink, ring, _c(ring));
+    EXPECT_EQ(cargv_int(&cargv, "TEST", &v, 3), CARGV_VAL_OVERFLOW);
+    EXPECT_EQ(cargv_error_at(&sink, 0)->offset, 2);
+    EXPECT_EQ(cargv_error_at(&sink, 0)->len, 20);
+    EXPECT_STREQ(cargv_error_at(&sink, 0)->arg, "99999999999999999999");
+
+    // Records outlive the argument, cut to the limit
+    std::string a = std::string(80, '0') + std::string(20, '9');
+
+    ASSERT_EQ(cargv_init_buffer(&cargv, _name, a.c_str(), a.size(), '\n'),
+              CARGV_OK);
+    cargv_set_error_sink(&cargv, &sink);
+    EXPECT_EQ(cargv_int(&cargv, "TEST", &v, 1), CARGV_VAL_OVERFLOW);
+    a.assign(100, 'x');
+    EXPECT_EQ(cargv_error_at(&sink, 1)->len, 100);
+    EXPECT_EQ(strlen(cargv_error_at(&sink, 1)->arg), CARGV_ERROR_ARG_MAX-1);
+    EXPECT_EQ(cargv_error_at(&sink, 1)->arg[0], '0');
+}
+
 TEST_F(Test_cargv, text)
 {
     static const char *args[] = { _name, "abc", "--text", "def", };
@@ -132,6 +573,67 @@ TEST_F(Test_cargv, oneof)
     EXPECT_EQ(cargv_shift(&cargv, 1), 0);
 }
 
+TEST_F(Test_cargv, choice)
+{
+    static const char *args[] = { _name, "dog", "cat", "", "cow", };
+    cargv_arena_t arena;
+    cargv_choiceset_t set;
+    cargv_len_t v[4];
+
+    cargv_arena_init(&arena, NULL, 0, 0);
+    ASSERT_EQ(cargv_init(&cargv, _name, _c(args), args), CARGV_OK);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    ASSERT_EQ(cargv_choiceset_init(&set, "|dog|cat|dog", "|", &arena),
+              CARGV_OK);
+    EXPECT_EQ(set.count, 4);
+    EXPECT_EQ(cargv_choice(&cargv, "CHOICE", &set, v, 4), 2);
+    EXPECT_EQ(v[0], 1);
+    EXPECT_EQ(v[1], 2);
+    EXPECT_EQ(cargv_choice(&cargv, "CHOICE", &set, v, 1), 1);
+
+    // Empty choices, as cargv_oneof()
+    const char *t[4];
+
+    EXPECT_EQ(cargv_shift(&cargv, 2), 2);
+    ASSERT_EQ(cargv_choiceset_init(&set, "|a|b", "|", &arena), CARGV_OK);
+    EXPECT_EQ(cargv_oneof(&cargv, "ONEOF", "|a|b", "|", t, 1), 0);
+    EXPECT_EQ(cargv_choice(&cargv, "CHOICE", &set, v, 1), 0);
+    ASSERT_EQ(cargv_init(&cargv, _name, _c(args), args), CARGV_OK);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    ASSERT_EQ(cargv_choiceset_init(&set, "dog||cat", "||", &arena),
+              CARGV_OK);
+    EXPECT_EQ(cargv_choice(&cargv, "CHOICE", &set, v, 4), 2);
+    EXPECT_EQ(v[1], 1);
+    ASSERT_EQ(cargv_choiceset_init(&set, "", "|", &arena), CARGV_OK);
+    EXPECT_EQ(cargv_choice(&cargv, "CHOICE", &set, v, 4), 0);
+    EXPECT_EQ(cargv_choiceset_init(&set, "dog", "", &arena),
+              CARGV_BAD_PARAM);
+
+    // Thousands of choices
+    std::string list;
+    std::vector<std::string> codes;
+    std::vector<const char *> cargs;
+    std::vector<cargv_len_t> idx(3000);
+    int i;
+
+    for (i = 0; i < 3000; ++i) {
+        codes.push_back("R" + std::to_string(i * 7919 % 100003));
+        list += (i ? "," : "") + codes.back();
+    }
+    for (i = 2999; i >= 0; --i)
+        cargs.push_back(codes[(size_t)i].c_str());
+    cargs.push_back("R-1");
+    ASSERT_EQ(cargv_choiceset_init(&set, list.c_str(), ",", &arena), CARGV_OK);
+    ASSERT_EQ(cargv_init(&cargv, _name, (int)cargs.size(), cargs.data()),
+              CARGV_OK);
+    EXPECT_EQ(cargv_choice(&cargv, "CHOICE", &set, idx.data(), 3000), 3000);
+    for (i = 0; i < 3000; ++i)
+        EXPECT_EQ(idx[(size_t)i], 2999 - i);
+    EXPECT_EQ(cargv_shift(&cargv, 3000), 3000);
+    EXPECT_EQ(cargv_choice(&cargv, "CHOICE", &set, v, 1), 0);
+    cargv_arena_release(&arena);
+}
+
 TEST_F(Test_cargv, sint)
 {
     static const char *args[] = { _name,
@@ -222,6 +724,122 @@ TEST_F(Test_cargv, uint)
     EXPECT_EQ(cargv_shift(&cargv, 1), 0);  // Ensure empty
 }
 
+TEST_F(Test_cargv, real)
+{
+    static const char *args[] = { _name,
+        "0", "-0", "1.5", "-0,25", ".5", "5.", "_1__000_.5", "1.000.000",
+        "1,234.5", "1.234,5", "6.02214076e23", "1E-3", "-2.5e+2",
+        "0.1", "9007199254740993", "2.2250738585072011e-308",
+        "4.9406564584124654e-324", "1e-400", "1.7976931348623157e308",
+        "123456789012345678901234567890e-30",
+        "1,000", "1.000", "12,34", "-1.000", "1.250e1", "1_000.500", ".500",
+    };
+    static const cargv_real_t expected[] = {
+        0.0, -0.0, 1.5, -0.25, 0.5, 5.0, 1000.5, 1000000.0,
+        1234.5, 1234.5, 6.02214076e23, 1E-3, -250.0,
+        0.1, 9007199254740992.0, 2.2250738585072009e-308,
+        4.9406564584124654e-324, 0.0, 1.7976931348623157e308,
+        123456789012345678901234567890e-30,
+        1000.0, 1000.0, 12.34, -1000.0, 12.5, 1000.5, 0.5,
+    };
+    cargv_real_t v;
+    cargv_real_t const *e = expected;
+
+    ASSERT_EQ(_c(args)-1, _c(expected));
+    ASSERT_EQ(cargv_init(&cargv, _name, _c(args), args), CARGV_OK);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    while (cargv_len(&cargv) > 0) {
+        EXPECT_EQ(cargv_real(&cargv, "TEST", &v, 1), 1) << *e;
+        EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+        EXPECT_EQ(memcmp(&v, e, sizeof(v)), 0) << v << " " << *e;
+        ++e;
+    }
+
+    // Single separators read as cargv_int() does
+    static const char *groups[] = { _name, "1,000", "1.000", };
+    cargv_int_t n[2];
+
+    ASSERT_EQ(cargv_init(&cargv, _name, _c(groups), groups), CARGV_OK);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    ASSERT_EQ(cargv_int(&cargv, "TEST", n, 2), 2);
+    EXPECT_EQ(n[0], 1000);
+    EXPECT_EQ(n[1], 1000);
+
+    static const char *bads[] = { _name,
+        "", ".", "-", "1e", "1e+", "1.2,3.4", "1,2,3.4.5", "1_234,567.8",
+        "1.5x", "0x10", "inf",
+    };
+    ASSERT_EQ(cargv_init(&cargv, _name, _c(bads), bads), CARGV_OK);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    while (cargv_len(&cargv) > 0) {
+        EXPECT_EQ(cargv_real(&cargv, "TEST", &v, 1), 0)
+            << bads[_c(bads) - cargv_len(&cargv)];
+        EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    }
+
+    static const char *overflows[] = { _name, "1.7976931348623159e308", };
+    ASSERT_EQ(cargv_init(&cargv, _name, _c(overflows), overflows), CARGV_OK);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    testing::internal::CaptureStderr();
+    EXPECT_EQ(cargv_real(&cargv, "TEST", &v, 1), CARGV_VAL_OVERFLOW);
+    EXPECT_EQ(testing::internal::GetCapturedStderr(),
+        "cargv-test: real number `TEST` overflows, which is "
+        "`1.7976931348623159e308`.\n");
+}
+
+TEST_F(Test_cargv, uint_long)
+{
+    static const char *args[] = { _name,
+        "000000000000000000000000000000000000000000000018446744073709551615",
+        "1_000_000_000_000_000_000",
+        "1234567890123456",
+        "12345678901234567",
+        "9999999999999999999",
+        "0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1",
+    };
+    static const cargv_uint_t expected[] = {
+        UINT64_C(18446744073709551615),
+        UINT64_C(1000000000000000000),
+        UINT64_C(1234567890123456),
+        UINT64_C(12345678901234567),
+        UINT64_C(9999999999999999999),
+        1,
+    };
+    cargv_uint_t v;
+    cargv_uint_t const *e = expected;
+
+    ASSERT_EQ(_c(args)-1, _c(expected));
+    ASSERT_EQ(cargv_init(&cargv, _name, _c(args), args), CARGV_OK);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    while (cargv_len(&cargv) > 0) {
+        EXPECT_EQ(cargv_uint(&cargv, "TEST", &v, 1), 1);
+        EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+        EXPECT_EQ(v, *e);
+        ++e;
+    }
+    EXPECT_EQ(cargv_shift(&cargv, 1), 0);  // Ensure empty
+}
+
+TEST_F(Test_cargv, uint_long_overflow)
+{
+    static const char *args[] = { _name,
+        "000000000000000000000000000000000000000000000018446744073709551616",
+        "99999999999999999999",
+        "18_446_744_073_709_551_616",
+    };
+    cargv_uint_t v;
+
+    ASSERT_EQ(cargv_init(&cargv, _name, _c(args), args), CARGV_OK);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    testing::internal::CaptureStderr();
+    while (cargv_len(&cargv) > 0) {
+        EXPECT_EQ(cargv_uint(&cargv, "TEST", &v, 1), CARGV_VAL_OVERFLOW);
+        EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    }
+    testing::internal::GetCapturedStderr();
+    EXPECT_EQ(cargv_shift(&cargv, 1), 0);  // Ensure empty
+}
+
 TEST_F(Test_cargv, uint_error)
 {
     static const char *args[] = { _name,
@@ -509,6 +1127,7 @@ TEST_F(Test_cargv, datetime)
         "--02-03 24:00-1",
         "--04/05T23:59:59-09:20",
         "10",
+        "25",
         "10Z",
         "23:59:59",
     };
@@ -528,6 +1147,8 @@ TEST_F(Test_cargv, datetime)
         {CARGV_YEAR_DEFAULT,4,5,23,59,59,0,{-9,-20}},
         {10,0,0,CARGV_HOUR_DEFAULT,CARGV_MINUTE_DEFAULT,CARGV_SECOND_DEFAULT,
          CARGV_MILISECOND_DEFAULT,*CARGV_TZ_LOCAL},
+        {25,0,0,CARGV_HOUR_DEFAULT,CARGV_MINUTE_DEFAULT,CARGV_SECOND_DEFAULT,
+         CARGV_MILISECOND_DEFAULT,*CARGV_TZ_LOCAL},
         {CARGV_YEAR_DEFAULT,CARGV_MONTH_DEFAULT,CARGV_DAY_DEFAULT,10,0,0,0,
          *CARGV_UTC},
         {CARGV_YEAR_DEFAULT,CARGV_MONTH_DEFAULT,CARGV_DAY_DEFAULT,23,59,59,0,
@@ -602,6 +1223,144 @@ TEST_F(Test_cargv, datetime_overflow)
     EXPECT_EQ(cargv_shift(&cargv, 1), 0);
 }
 
+TEST_F(Test_cargv, datetime_format)
+{
+    static const char *args[] = { _name,
+        "20190603T235959Z", "2019-06-03 23:59:59Z", "20190603",
+        "2019/06/03", "235959", "23:59:59", "2019-06-03T08:00+09:30",
+        "20190603T2359", "2019O603T235959Z",
+    };
+    static const cargv_datetime_format_t formats[] = {
+        CARGV_FORMAT_DATETIME_BASIC_Z, CARGV_FORMAT_DATETIME_EXTENDED_Z,
+        CARGV_FORMAT_DATE_BASIC, CARGV_FORMAT_DATE_EXTENDED,
+        CARGV_FORMAT_TIME_BASIC, CARGV_FORMAT_TIME_EXTENDED,
+        CARGV_FORMAT_DATETIME_EXTENDED, CARGV_FORMAT_DATETIME_BASIC,
+        CARGV_FORMAT_DATETIME_BASIC_Z,
+    };
+    cargv_datetime_t v, w;
+    cargv_len_t r;
+    int i;
+
+    ASSERT_EQ(_c(args)-1, _c(formats));
+    ASSERT_EQ(cargv_init(&cargv, _name, _c(args), args), CARGV_OK);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    EXPECT_EQ(cargv_datetime_format(
+        &cargv, "TEST", CARGV_FORMAT_DATETIME_BASIC_Z, &v, 1), 1);
+    EXPECT_EQ(v.year, 2019);
+    EXPECT_EQ(v.day, 3);
+    EXPECT_EQ(v.second, 59);
+    EXPECT_EQ(v.tz.hour, 0);
+
+    // Same as readers without a hint, whether in the format or not
+    for (i = 0; cargv_len(&cargv) > 0; ++i) {
+        memset(&v, 0, sizeof(v));
+        memset(&w, 0, sizeof(w));
+        r = cargv_datetime(&cargv, "TEST", &w, 1);
+        EXPECT_EQ(cargv_datetime_format(&cargv, "TEST", formats[i], &v, 1), r)
+            << args[i+1];
+        EXPECT_EQ(memcmp(&v, &w, sizeof(v)), 0) << args[i+1];
+        r = cargv_date(&cargv, "TEST", &w, 1);
+        EXPECT_EQ(cargv_date_format(&cargv, "TEST", formats[i], &v, 1), r);
+        EXPECT_EQ(memcmp(&v, &w, sizeof(v)), 0) << args[i+1];
+        r = cargv_time(&cargv, "TEST", &w, 1);
+        EXPECT_EQ(cargv_time_format(&cargv, "TEST", formats[i], &v, 1), r);
+        EXPECT_EQ(memcmp(&v, &w, sizeof(v)), 0) << args[i+1];
+        EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    }
+
+    static const char *overflows[] = { _name,
+        "20191303T000000Z", "20190229T000000Z", "20190603T240001Z",
+    };
+    ASSERT_EQ(cargv_init(&cargv, _name, _c(overflows), overflows), CARGV_OK);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    testing::internal::CaptureStderr();
+    while (cargv_len(&cargv) > 0) {
+        EXPECT_EQ(cargv_datetime_format(&cargv, "TEST",
+                      CARGV_FORMAT_DATETIME_BASIC_Z, &v, 1),
+                  CARGV_VAL_OVERFLOW);
+        EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    }
+    testing::internal::GetCapturedStderr();
+}
+
+TEST_F(Test_cargv, datetime_predict)
+{
+    static const char *args[] = { _name,
+        "2019-06-03T23:59:59Z", "2019-06-04T00:00:00Z", "2019-06-04T00:00:01Z",
+        "20190604", "2019-06-04T00:00:02Z", "2019-06-04T00:00:03Z",
+        "20190605", "20190606", "20190607", "20190608", "20190609",
+    };
+    cargv_datetime_t v[_c(args)-1], w;
+    cargv_len_t i;
+
+    ASSERT_EQ(cargv_init(&cargv, _name, _c(args), args), CARGV_OK);
+    EXPECT_EQ(cargv.predict, CARGV_FORMAT_ANY);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    EXPECT_EQ(cargv_datetime(&cargv, "TEST", v, _c(v)), _c(v));
+    EXPECT_EQ(cargv.predict, CARGV_FORMAT_DATE_BASIC);
+    EXPECT_EQ(cargv.predict_hits, 5);
+    EXPECT_EQ(cargv.predict_misses, 6);
+
+    // Same values as read without a prediction
+    ASSERT_EQ(cargv_init(&cargv, _name, _c(args), args), CARGV_OK);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    for (i = 0; i < _c(v); ++i) {
+        cargv.predict = CARGV_FORMAT_ANY;
+        cargv.predict_conf = 0;
+        memset(&w, 0, sizeof(w));
+        EXPECT_EQ(cargv_datetime(&cargv, "TEST", &w, 1), 1) << args[i+1];
+        EXPECT_EQ(memcmp(&v[i], &w, sizeof(w)), 0) << args[i+1];
+        EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    }
+
+    // Wrong in the predicted format
+    static const char *overflows[] = { _name, "2019-06-04T24:00:01Z" };
+    ASSERT_EQ(cargv_init(&cargv, _name, _c(overflows), overflows), CARGV_OK);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    cargv.predict = CARGV_FORMAT_DATETIME_EXTENDED_Z;
+    testing::internal::CaptureStderr();
+    EXPECT_EQ(cargv_datetime(&cargv, "TEST", v, 1), CARGV_VAL_OVERFLOW);
+    testing::internal::GetCapturedStderr();
+    EXPECT_EQ(cargv.predict_hits, 1);
+}
+
+TEST_F(Test_cargv, datetime_packed)
+{
+    static const char *args[] = { _name,
+        "+1999-06-3T08:00+9:30",
+        "45-01-23 1:2:3",
+        "--2-29",
+        "10",
+        "10Z",
+        "23:59:59",
+    };
+    cargv_datetime_packed_t p[_c(args)-1];
+    cargv_datetime_t v[_c(args)-1], u;
+
+    EXPECT_EQ(sizeof(cargv_datetime_packed_t), 12u);
+    ASSERT_EQ(cargv_init(&cargv, _name, _c(args), args), CARGV_OK);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    EXPECT_EQ(cargv_datetime(&cargv, "TEST", v, _c(v)), _c(v));
+    EXPECT_EQ(cargv_datetime_packed(&cargv, "TEST", p, _c(p)), _c(p));
+
+    EXPECT_EQ(p[0].present, 0xFF);
+    EXPECT_EQ(p[0].tz_minute, 30);
+    EXPECT_EQ(p[1].present & CARGV_HAS_TZ, 0);
+    EXPECT_EQ(p[2].present, CARGV_HAS_MONTH | CARGV_HAS_DAY);
+    EXPECT_EQ(p[3].year, 10);
+    EXPECT_EQ(p[4].present & CARGV_HAS_YEAR, 0);
+    for (ptrdiff_t i = 0; i < _c(v); ++i) {
+        cargv_unpack_datetime(&u, &p[i]);
+        EXPECT_EQ(memcmp(&u, &v[i], sizeof(u)), 0);
+    }
+
+    EXPECT_EQ(cargv_date_packed(&cargv, "TEST", p, 1), 0);
+    EXPECT_EQ(cargv_shift(&cargv, 5), 5);
+    EXPECT_EQ(cargv_time_packed(&cargv, "TEST", p, 1), 1);
+    EXPECT_EQ(p[0].hour, 23);
+    EXPECT_EQ(p[0].present & CARGV_HAS_YEAR, 0);
+}
+
 TEST_F(Test_cargv, local_datetime)
 {
     static const cargv_datetime_t srcs[] = {
@@ -662,6 +1421,373 @@ TEST_F(Test_cargv, local_datetime_overflow)
     }
 }
 
+TEST_F(Test_cargv, local_datetimes)
+{
+    static const int N = 1000;
+    std::vector<cargv_datetime_t> srcs(N), dsts(N);
+    cargv_datetime_t v;
+
+    // More than a day, across the end of a month and a year
+    static const cargv_datetime_t far = {2019,12,31,23,30,0,0,{-12,-59}};
+    static const cargv_timezone_t east = {14,0};
+    EXPECT_EQ(cargv_local_datetime(&v, &far, &east), CARGV_OK);
+    EXPECT_EQ(v.year, 2020);
+    EXPECT_EQ(v.month, 1);
+    EXPECT_EQ(v.day, 2);
+    EXPECT_EQ(v.hour, 2);
+    EXPECT_EQ(v.minute, 29);
+
+    // Without the year, in a leap year
+    static const cargv_datetime_t noyear = {
+        CARGV_YEAR_DEFAULT,2,28,23,0,0,0,{0,0}};
+    EXPECT_EQ(cargv_local_datetime(&v, &noyear, &east), CARGV_OK);
+    EXPECT_EQ(v.year, CARGV_YEAR_DEFAULT);
+    EXPECT_EQ(v.month, 2);
+    EXPECT_EQ(v.day, 29);
+    EXPECT_EQ(v.hour, 13);
+
+    // Each value in its own time zone, as converted one by one
+    for (int i = 0; i < N; ++i) {
+        srcs[i] = {(cargv_int_t)(i * 19 - 9500), i % 12 + 1, i % 28 + 1,
+                   i % 24, i % 60, i % 60, i % 1000,
+                   {i % 27 - 12, (i % 27 - 12 < 0) ? -(i % 60) : i % 60}};
+    }
+    srcs[0] = far;
+    srcs[1] = noyear;
+    srcs[2].day = CARGV_DAY_DEFAULT;
+    srcs[3].tz = *CARGV_TZ_LOCAL;
+    EXPECT_EQ(cargv_local_datetimes(dsts.data(), srcs.data(), N, &east), N);
+    for (int i = 0; i < N; ++i) {
+        ASSERT_EQ(cargv_local_datetime(&v, &srcs[i], &east), CARGV_OK);
+        EXPECT_EQ(memcmp(&v, &dsts[i], sizeof(v)), 0) << i;
+    }
+    EXPECT_EQ(cargv_local_datetimes(dsts.data(), srcs.data(), N, NULL), N);
+    EXPECT_EQ(dsts[0].day, 1);
+    EXPECT_EQ(dsts[0].hour, 12);
+    EXPECT_EQ(dsts[0].minute, 29);
+
+    // In place, stopping at the first failure
+    srcs[700].month = 13;
+    dsts = srcs;
+    EXPECT_EQ(cargv_local_datetimes(dsts.data(), dsts.data(), N, CARGV_UTC),
+              700);
+    for (int i = 0; i < 700; ++i) {
+        ASSERT_EQ(cargv_local_datetime(&v, &srcs[i], CARGV_UTC), CARGV_OK);
+        EXPECT_EQ(memcmp(&v, &dsts[i], sizeof(v)), 0) << i;
+    }
+    EXPECT_EQ(memcmp(&srcs[700], &dsts[700], sizeof(v)), 0);
+}
+
+TEST_F(Test_cargv, epoch)
+{
+    static const struct {
+        cargv_datetime_t dt;
+        cargv_int_t epoch;
+    } cases[] = {
+        {{1970,1,1,0,0,0,0,{0,0}}, 0},
+        {{1969,12,31,23,59,59,0,{0,0}}, -1},
+        {{2019,6,3,8,0,0,0,{9,30}}, 1559514600},
+        {{2000,2,29,23,59,59,0,{-1,0}}, 951872399},
+        {{1,1,1,0,0,0,0,{0,0}}, -62135596800},
+        {{9999,12,31,23,59,59,0,{0,0}}, 253402300799},
+        {{1999,12,31,24,0,0,0,{0,0}}, 946684800},
+        {{2019,CARGV_MONTH_DEFAULT,CARGV_DAY_DEFAULT,CARGV_HOUR_DEFAULT,
+          CARGV_MINUTE_DEFAULT,CARGV_SECOND_DEFAULT,CARGV_MILISECOND_DEFAULT,
+          {0,0}}, 1546300800},
+    };
+    cargv_int_t e;
+
+    for (size_t i = 0; i < sizeof(cases)/sizeof(cases[0]); ++i) {
+        EXPECT_EQ(cargv_datetime_to_epoch(&e, &cases[i].dt,
+                                          CARGV_EPOCH_SECOND), CARGV_OK);
+        EXPECT_EQ(e, cases[i].epoch);
+    }
+
+    static const cargv_datetime_t ms = {1969,12,31,23,59,59,250,{0,0}};
+    EXPECT_EQ(cargv_datetime_to_epoch(&e, &ms, CARGV_EPOCH_SECOND), CARGV_OK);
+    EXPECT_EQ(e, -1);
+    EXPECT_EQ(cargv_datetime_to_epoch(&e, &ms, CARGV_EPOCH_MILISECOND),
+              CARGV_OK);
+    EXPECT_EQ(e, -750);
+    EXPECT_EQ(cargv_datetime_to_epoch(&e, &ms, CARGV_EPOCH_NANOSECOND),
+              CARGV_OK);
+    EXPECT_EQ(e, -750000000);
+
+    cargv_datetime_t v;
+    EXPECT_EQ(cargv_epoch_to_datetime(&v, 1559514600123,
+                                      CARGV_EPOCH_MILISECOND,
+                                      CARGV_TZ_SOUTH_KOREA), CARGV_OK);
+    EXPECT_EQ(v.year, 2019);
+    EXPECT_EQ(v.month, 6);
+    EXPECT_EQ(v.day, 3);
+    EXPECT_EQ(v.hour, 7);
+    EXPECT_EQ(v.minute, 30);
+    EXPECT_EQ(v.second, 0);
+    EXPECT_EQ(v.milisecond, 123);
+    EXPECT_EQ(v.tz.hour, 9);
+    EXPECT_EQ(cargv_epoch_to_datetime(&v, -1, CARGV_EPOCH_NANOSECOND, NULL),
+              CARGV_OK);
+    EXPECT_EQ(v.year, 1969);
+    EXPECT_EQ(v.second, 59);
+    EXPECT_EQ(v.milisecond, 999);
+}
+
+TEST_F(Test_cargv, epoch_error)
+{
+    static const cargv_datetime_t overflows[] = {
+        {9999,12,31,0,0,0,0,{0,0}},     // Too far for nanoseconds
+        {2019,2,29,0,0,0,0,{0,0}},
+        {2019,1,1,24,0,1,0,{0,0}},
+        {2019,13,1,0,0,0,0,{0,0}},
+        {2019,1,1,0,0,0,1000,{0,0}},
+    };
+    static const cargv_datetime_t omitted[] = {
+        {CARGV_YEAR_DEFAULT,1,1,0,0,0,0,{0,0}},
+        {CARGV_YEAR_DEFAULT,1,1,0,0,0,0,*CARGV_TZ_LOCAL},
+    };
+    cargv_int_t e, es[_c(overflows)];
+    cargv_datetime_t v;
+
+    for (size_t i = 0; i < sizeof(overflows)/sizeof(overflows[0]); ++i)
+        EXPECT_EQ(cargv_datetime_to_epoch(&e, &overflows[i],
+                                          CARGV_EPOCH_NANOSECOND),
+                  CARGV_VAL_OVERFLOW);
+    for (size_t i = 0; i < sizeof(omitted)/sizeof(omitted[0]); ++i)
+        EXPECT_EQ(cargv_datetime_to_epoch(&e, &omitted[i],
+                                          CARGV_EPOCH_SECOND),
+                  CARGV_BAD_PARAM);
+    EXPECT_EQ(cargv_datetimes_to_epochs(es, overflows, _c(overflows),
+                                        CARGV_EPOCH_NANOSECOND), 0);
+    EXPECT_EQ(cargv_datetimes_to_epochs(es, overflows+1, 1,
+                                        CARGV_EPOCH_SECOND), 0);
+
+    EXPECT_EQ(cargv_epoch_to_datetime(&v, CARGV_SINT_MAX, CARGV_EPOCH_SECOND,
+                                      CARGV_UTC), CARGV_VAL_OVERFLOW);
+    EXPECT_EQ(cargv_epoch_to_datetime(&v, CARGV_SINT_MAX, CARGV_EPOCH_SECOND,
+                                      CARGV_TZ_LOCAL), CARGV_VAL_OVERFLOW);
+}
+
+TEST_F(Test_cargv, epoch_local)
+{
+    static const cargv_int_t epochs[] = {
+        0, 1546516800, 1559563200, 1572766200, 1583800200, 2000000000,
+    };
+    std::vector<cargv_datetime_t> dts(_c(epochs));
+    std::vector<cargv_int_t> back(_c(epochs));
+    const cargv_zone_t *z, *y;
+    cargv_datetime_t v;
+    cargv_int_t e;
+
+    ASSERT_EQ(cargv_zone_local(&z), CARGV_OK);
+    ASSERT_EQ(cargv_zone_local(&y), CARGV_OK);
+    EXPECT_EQ(z, y);
+
+    // Same as libc
+    for (int i = 0; i < _c(epochs); ++i) {
+        time_t t = (time_t)epochs[i];
+        struct tm tm = *localtime(&t);
+
+        ASSERT_EQ(cargv_epoch_to_datetime(&v, epochs[i], CARGV_EPOCH_SECOND,
+                                          CARGV_TZ_LOCAL), CARGV_OK);
+        EXPECT_EQ(v.year, tm.tm_year + 1900);
+        EXPECT_EQ(v.month, tm.tm_mon + 1);
+        EXPECT_EQ(v.day, tm.tm_mday);
+        EXPECT_EQ(v.hour, tm.tm_hour);
+        EXPECT_EQ(v.minute, tm.tm_min);
+
+        v.tz = *CARGV_TZ_LOCAL;
+        EXPECT_EQ(cargv_datetime_to_epoch(&e, &v, CARGV_EPOCH_SECOND),
+                  CARGV_OK);
+        EXPECT_EQ(e, (cargv_int_t)mktime(&tm));
+    }
+
+    EXPECT_EQ(cargv_epochs_to_datetimes(dts.data(), epochs, _c(epochs),
+                                        CARGV_EPOCH_SECOND, CARGV_TZ_LOCAL),
+              _c(epochs));
+    for (auto &d : dts)
+        d.tz = *CARGV_TZ_LOCAL;
+    EXPECT_EQ(cargv_datetimes_to_epochs(back.data(), dts.data(), _c(epochs),
+                                        CARGV_EPOCH_SECOND), _c(epochs));
+    for (int i = 0; i < _c(epochs); ++i) {
+        time_t t = (time_t)epochs[i];
+        struct tm tm = *localtime(&t);
+        EXPECT_EQ(back[i], (cargv_int_t)mktime(&tm));
+    }
+
+    // Local time as the source, and the target
+    v = {2019, 6, 3, 8, 0, 0, 0, *CARGV_TZ_LOCAL};
+    ASSERT_EQ(cargv_datetime_to_epoch(&e, &v, CARGV_EPOCH_SECOND), CARGV_OK);
+    cargv_datetime_t u, w;
+    EXPECT_EQ(cargv_local_datetime(&u, &v, CARGV_UTC), CARGV_OK);
+    EXPECT_EQ(cargv_epoch_to_datetime(&w, e, CARGV_EPOCH_SECOND, CARGV_UTC),
+              CARGV_OK);
+    EXPECT_EQ(u.day, w.day);
+    EXPECT_EQ(u.hour, w.hour);
+    EXPECT_EQ(u.minute, w.minute);
+    EXPECT_EQ(cargv_local_datetime(&u, &w, CARGV_TZ_LOCAL), CARGV_OK);
+    EXPECT_EQ(u.day, 3);
+    EXPECT_EQ(u.hour, 8);
+    EXPECT_EQ(u.minute, 0);
+}
+
+TEST_F(Test_cargv, epochs)
+{
+    static const int N = 1000;
+    std::vector<cargv_int_t> epochs(N), back(N);
+    std::vector<cargv_datetime_t> dts(N);
+
+    for (int i = 0; i < N; ++i)
+        epochs[i] = (cargv_int_t)(i - 600) * 86400 * 5000 + i * 4321;
+    EXPECT_EQ(cargv_epochs_to_datetimes(dts.data(), epochs.data(), N,
+                                        CARGV_EPOCH_SECOND, CARGV_TZ_US_PST),
+              N);
+    EXPECT_EQ(cargv_datetimes_to_epochs(back.data(), dts.data(), N,
+                                        CARGV_EPOCH_SECOND), N);
+    EXPECT_EQ(epochs, back);
+
+    dts[700].month = 13;
+    EXPECT_EQ(cargv_datetimes_to_epochs(back.data(), dts.data(), N,
+                                        CARGV_EPOCH_SECOND), 700);
+}
+
+TEST_F(Test_cargv, zone)
+{
+    const cargv_zone_t *z, *y;
+    cargv_timezone_t tz;
+    cargv_datetime_t v;
+
+    EXPECT_EQ(cargv_zone_load(&z, "../etc/passwd"), CARGV_BAD_PARAM);
+    EXPECT_EQ(cargv_zone_load(&z, "/etc/passwd"), CARGV_BAD_PARAM);
+    EXPECT_EQ(cargv_zone_load(&z, "Asia/"), CARGV_BAD_PARAM);
+    EXPECT_EQ(cargv_zone_load(&z, "Asia/../Seoul"), CARGV_BAD_PARAM);
+    EXPECT_EQ(cargv_zone_load(&z, "Asia/Se oul"), CARGV_BAD_PARAM);
+    EXPECT_EQ(cargv_zone_load(&z, "Nowhere/Land"), CARGV_IO_ERROR);
+    if (cargv_zone_load(&z, "America/Los_Angeles") != CARGV_OK)
+        return;     // No tz database
+    ASSERT_EQ(cargv_zone_load(&y, "America/Los_Angeles"), CARGV_OK);
+    EXPECT_EQ(z, y);
+
+    EXPECT_EQ(cargv_zone_offset(&tz, z, 1559563200), CARGV_OK);
+    EXPECT_EQ(tz.hour, -7);
+    EXPECT_EQ(cargv_zone_offset(&tz, z, 1546516800), CARGV_OK);
+    EXPECT_EQ(tz.hour, -8);
+    EXPECT_EQ(cargv_zone_offset(&tz, z, 10429430400), CARGV_OK);  // 2300
+    EXPECT_EQ(tz.hour, -7);
+
+    // Skipped, and repeated local times
+    v = {2019, 3, 10, 2, 30, 0, 0, {0, 0}};
+    EXPECT_EQ(cargv_zone_local_offset(&tz, z, &v), CARGV_OK);
+    EXPECT_EQ(tz.hour, -8);
+    v = {2019, 11, 3, 1, 30, 0, 0, {0, 0}};
+    EXPECT_EQ(cargv_zone_local_offset(&tz, z, &v), CARGV_OK);
+    EXPECT_EQ(tz.hour, -7);
+
+    ASSERT_EQ(cargv_zone_load(&y, "Asia/Kolkata"), CARGV_OK);
+    EXPECT_EQ(cargv_zone_offset(&tz, y, 1559563200), CARGV_OK);
+    EXPECT_EQ(tz.hour, 5);
+    EXPECT_EQ(tz.minute, 30);
+
+#ifndef _WIN32
+    // Failed names are not read again
+    std::string dir = testing::TempDir();
+    std::vector<char> tzif(1 << 16);
+    FILE *f;
+    size_t n;
+
+    ASSERT_NE(f = fopen("/usr/share/zoneinfo/UTC", "rb"), nullptr);
+    n = fread(tzif.data(), 1, tzif.size(), f);
+    fclose(f);
+    EXPECT_EQ(cargv_zone_load(&z, "Cargv_missing"), CARGV_IO_ERROR);
+    for (const char *name : {"Cargv_missing", "Cargv_found"}) {
+        ASSERT_NE(f = fopen((dir + name).c_str(), "wb"), nullptr);
+        fwrite(tzif.data(), 1, n, f);
+        fclose(f);
+    }
+    setenv("TZDIR", dir.c_str(), 1);
+    EXPECT_EQ(cargv_zone_load(&z, "Cargv_missing"), CARGV_IO_ERROR);
+    EXPECT_EQ(cargv_zone_load(&z, "Cargv_found"), CARGV_OK);
+    unsetenv("TZDIR");
+#endif
+}
+
+TEST_F(Test_cargv, zone_args)
+{
+    static const char *args[] = { _name,
+        "2019-06-03T08:00[America/Los_Angeles]",
+        "2019-01-03 08:00:00[America/Los_Angeles]",
+        "2019-06-03T08:00+09:00[America/Los_Angeles]",
+        "2019-06-03T08:00[Nowhere/Land]",
+    };
+    static const char *tzs[] = { _name, "Asia/Kolkata", "[Asia/Seoul]" };
+    cargv_datetime_t v[_c(args)-1];
+    cargv_timezone_t tz[_c(tzs)-1];
+    const cargv_zone_t *z;
+
+    if (cargv_zone_load(&z, "America/Los_Angeles") != CARGV_OK)
+        return;     // No tz database
+
+    ASSERT_EQ(cargv_init(&cargv, _name, _c(args), args), CARGV_OK);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    EXPECT_EQ(cargv_datetime(&cargv, "TEST", v, _c(v)), 3);
+    EXPECT_EQ(v[0].hour, 8);
+    EXPECT_EQ(v[0].tz.hour, -7);
+    EXPECT_EQ(v[1].tz.hour, -8);
+    EXPECT_EQ(v[2].tz.hour, 9);
+    EXPECT_EQ(cargv_shift(&cargv, 3), 3);
+    EXPECT_EQ(cargv_datetime(&cargv, "TEST", v, _c(v)), 0);
+
+    // Same in parallel, and packed
+    cargv_datetime_t w[_c(v)];
+    cargv_datetime_packed_t p[_c(v)];
+    int i;
+
+    ASSERT_EQ(cargv_init(&cargv, _name, _c(args), args), CARGV_OK);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    ASSERT_EQ(cargv_datetime(&cargv, "TEST", v, _c(v)), 3);
+    ASSERT_EQ(cargv_datetime_parallel(&cargv, "TEST", w, _c(w), 2), 3);
+    ASSERT_EQ(cargv_datetime_packed(&cargv, "TEST", p, _c(p)), 3);
+    for (i = 0; i < 3; ++i) {
+        EXPECT_EQ(w[i].hour, v[i].hour);
+        EXPECT_EQ(w[i].tz.hour, v[i].tz.hour);
+        EXPECT_EQ(w[i].tz.minute, v[i].tz.minute);
+        EXPECT_EQ(p[i].hour, v[i].hour);
+        EXPECT_EQ(p[i].tz_hour, v[i].tz.hour);
+        EXPECT_EQ(p[i].tz_minute, v[i].tz.minute);
+    }
+
+    // Many zoned values in threads, switching zones
+    std::vector<const char *> many(1, _name);
+
+    for (i = 0; i < 10000; ++i)
+        many.push_back((i % 3) ? "2019-06-03T08:00[America/Los_Angeles]"
+                               : "2019-06-03T08:00[Asia/Kolkata]");
+    std::vector<cargv_datetime_t> vs(many.size());
+
+    ASSERT_EQ(cargv_init(&cargv, _name, (cargv_len_t)many.size(),
+                         many.data()), CARGV_OK);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    ASSERT_EQ(cargv_datetime_parallel(&cargv, "TEST", vs.data(), 10000, 4),
+              10000);
+    for (i = 0; i < 10000; ++i)
+        ASSERT_EQ(vs[(size_t)i].tz.hour, (i % 3) ? -7 : 5);
+
+    static const char *times[] = { _name, "08:00[America/Los_Angeles]", };
+
+    ASSERT_EQ(cargv_init(&cargv, _name, _c(times), times), CARGV_OK);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    ASSERT_EQ(cargv_time(&cargv, "TEST", v, 1), 1);
+    ASSERT_EQ(cargv_time_packed(&cargv, "TEST", p, 1), 1);
+    EXPECT_TRUE(p[0].present & CARGV_HAS_TZ);
+    EXPECT_EQ(p[0].tz_hour, v[0].tz.hour);
+
+    ASSERT_EQ(cargv_init(&cargv, _name, _c(tzs), tzs), CARGV_OK);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    EXPECT_EQ(cargv_timezone(&cargv, "TEST", tz, _c(tz)), _c(tz));
+    EXPECT_EQ(tz[0].hour, 5);
+    EXPECT_EQ(tz[0].minute, 30);
+    EXPECT_EQ(tz[1].hour, 9);
+}
+
 TEST_F(Test_cargv, degree)
 {
     static const char *args[] = { _name,
@@ -805,6 +1931,102 @@ TEST_F(Test_cargv, geocoord)
     EXPECT_EQ(cargv_shift(&cargv, 1), 0);  // Ensure empty
 }
 
+TEST_F(Test_cargv, geocoord_columns)
+{
+    static const char *args[] = { _name,
+        "-32.3957+13239.57/",
+        "+62.3-0",
+        "+3734+12658/",
+        "+373456.5-1222500/",
+    };
+    static const cargv_int_t lats[] = {
+        -32395700000, 62300000000, 37566666667, 37582361111,
+    };
+    static const cargv_int_t lons[] = {
+        132659500000, 0, 126966666667, -122416666667,
+    };
+    cargv_real_t rlat[_c(lats)], rlon[_c(lons)];
+    cargv_int_t nlat[_c(lats)], nlon[_c(lons)];
+    cargv_geocoord_t v[_c(lats)];
+
+    ASSERT_EQ(cargv_init(&cargv, _name, _c(args), args), CARGV_OK);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    EXPECT_EQ(cargv_geocoord(&cargv, "TEST", v, _c(v)), _c(v));
+    EXPECT_EQ(cargv_geocoord_real(&cargv, "TEST", rlat, rlon, _c(rlat)),
+              _c(rlat));
+    EXPECT_EQ(cargv_geocoord_nano(&cargv, "TEST", nlat, nlon, _c(nlat)),
+              _c(nlat));
+    for (ptrdiff_t i = 0; i < _c(lats); ++i) {
+        EXPECT_EQ(rlat[i], cargv_get_degree(&v[i].latitude));
+        EXPECT_EQ(rlon[i], cargv_get_degree(&v[i].longitude));
+        EXPECT_EQ(nlat[i], lats[i]);
+        EXPECT_EQ(nlon[i], lons[i]);
+    }
+
+
+    static const char *degs[] = { _name, "+62.3", "-12225.5", };
+
+    ASSERT_EQ(cargv_init(&cargv, _name, _c(degs), degs), CARGV_OK);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    EXPECT_EQ(cargv_degree_nano(&cargv, "TEST", nlat, 2), 2);
+    EXPECT_EQ(nlat[0], 62300000000);
+    EXPECT_EQ(nlat[1], -122425000000);
+    EXPECT_EQ(cargv_degree_real(&cargv, "TEST", rlat, 2), 2);
+    EXPECT_EQ(rlat[0], 62.3);
+}
+
+TEST_F(Test_cargv, parallel)
+{
+    static const int N = 20000;
+    std::vector<std::string> strs(N + 1);
+    std::vector<const char *> args(N + 1);
+    std::vector<cargv_int_t> v(N), w(N);
+
+    strs[0] = _name;
+    for (int i = 1; i <= N; ++i)
+        strs[i] = std::to_string((long long)i * 7919 - 50000000);
+    strs[15001] = "x";
+    strs[17001] = "99999999999999999999";
+    for (int i = 0; i <= N; ++i)
+        args[i] = strs[i].c_str();
+
+    ASSERT_EQ(cargv_init(&cargv, _name, N + 1, args.data()), CARGV_OK);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    EXPECT_EQ(cargv_int(&cargv, "TEST", v.data(), N), 15000);
+    EXPECT_EQ(cargv_int_parallel(&cargv, "TEST", w.data(), N, 4), 15000);
+    EXPECT_TRUE(std::equal(v.begin(), v.begin() + 15000, w.begin()));
+    EXPECT_EQ(cargv_int_parallel(&cargv, "TEST", w.data(), 100, 4), 100);
+
+    strs[9001] = "-99999999999999999999";
+    args[9001] = strs[9001].c_str();
+    testing::internal::CaptureStderr();
+    EXPECT_EQ(cargv_int_parallel(&cargv, "TEST", w.data(), N, 4),
+              CARGV_VAL_OVERFLOW);
+    EXPECT_NE(testing::internal::GetCapturedStderr().find(strs[9001]),
+              std::string::npos);
+}
+
+TEST_F(Test_cargv, parallel_datetime)
+{
+    static const char *args[] = { _name,
+        "+1999-06-3T08:00+9:30", "--02-03 24:00-1", "+3734+12658/",
+    };
+    cargv_datetime_t d[2];
+    cargv_geocoord_t g;
+
+    ASSERT_EQ(cargv_init(&cargv, _name, _c(args), args), CARGV_OK);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    EXPECT_EQ(cargv_datetime_parallel(&cargv, "TEST", d, 0, 0), 0);
+    EXPECT_EQ(cargv_datetime_parallel(&cargv, "TEST", d, -1, 0), 0);
+    EXPECT_EQ(cargv_datetime(&cargv, "TEST", d, -1), 0);
+    EXPECT_EQ(cargv_datetime_parallel(&cargv, "TEST", d, 3, 0), 2);
+    EXPECT_EQ(d[0].tz.minute, 30);
+    EXPECT_EQ(d[1].hour, 24);
+    EXPECT_EQ(cargv_shift(&cargv, 2), 2);
+    EXPECT_EQ(cargv_geocoord_parallel(&cargv, "TEST", &g, 1, 0), 1);
+    EXPECT_EQ(g.latitude.degree, 37);
+}
+
 TEST_F(Test_cargv, geocoord_error)
 {
     static const char *args[] = { _name,
@@ -840,3 +2062,138 @@ TEST_F(Test_cargv, geocoord_overflow)
     testing::internal::GetCapturedStderr();
     EXPECT_EQ(cargv_shift(&cargv, 1), 0);  // Ensure empty
 }
+
+TEST_F(Test_cargv, dispatch)
+{
+    static const char *args[] = { _name,
+        "-v", "--size", "10", "-vvo", "out", "1", "-2", "--when",
+        "2019-06-03T08:00Z", "3", "--size", "+20", "--", "-v", "file",
+    };
+    cargv_int_t sizes[4], nums[3];
+    cargv_datetime_t when;
+    const char *out, *texts[4];
+    struct cargv_spec_t specs[] = {
+        {"-v--verbose", CARGV_FLAG, "VERBOSE", NULL, 0, NULL, NULL, 0},
+        {"--size", CARGV_INT, "SIZE", sizes, _c(sizes), NULL, NULL, 0},
+        {"-o--out", CARGV_TEXT, "OUT", &out, 1, NULL, NULL, 0},
+        {"--when", CARGV_DATETIME, "WHEN", &when, 1, NULL, NULL, 0},
+        {NULL, CARGV_INT, "NUM", nums, _c(nums), NULL, NULL, 0},
+        {NULL, CARGV_TEXT, "TEXT", texts, _c(texts), NULL, NULL, 0},
+    };
+
+    ASSERT_EQ(cargv_init(&cargv, _name, _c(args), args), CARGV_OK);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    EXPECT_EQ(cargv_dispatch(&cargv, specs, _c(specs)), _c(args)-1);
+    EXPECT_EQ(cargv_len(&cargv), 0);
+    EXPECT_EQ(specs[0].count, 3);
+    ASSERT_EQ(specs[1].count, 2);
+    EXPECT_EQ(sizes[0], 10);
+    EXPECT_EQ(sizes[1], 20);
+    ASSERT_EQ(specs[2].count, 1);
+    EXPECT_STREQ(out, "out");
+    ASSERT_EQ(specs[3].count, 1);
+    EXPECT_EQ(when.hour, 8);
+    ASSERT_EQ(specs[4].count, 3);
+    EXPECT_EQ(nums[0], 1);
+    EXPECT_EQ(nums[1], -2);
+    EXPECT_EQ(nums[2], 3);
+    ASSERT_EQ(specs[5].count, 2);
+    EXPECT_STREQ(texts[0], "-v");
+    EXPECT_STREQ(texts[1], "file");
+}
+
+TEST_F(Test_cargv, dispatch_stop)
+{
+    static const char *args[] = { _name,
+        "-v", "--size", "x", "--unknown", "12345678901234567890",
+    };
+    cargv_int_t size, num;
+    struct cargv_spec_t specs[] = {
+        {"-v", CARGV_FLAG, "VERBOSE", NULL, 0, NULL, NULL, 0},
+        {"--size", CARGV_INT, "SIZE", &size, 1, NULL, NULL, 0},
+        {"-*", CARGV_FLAG, "ANY", NULL, 0, NULL, NULL, 0},
+        {NULL, CARGV_INT, "NUM", &num, 1, NULL, NULL, 0},
+    };
+
+    ASSERT_EQ(cargv_init(&cargv, _name, _c(args), args), CARGV_OK);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+
+    // Missing value
+    EXPECT_EQ(cargv_dispatch(&cargv, specs, 2), 1);
+    EXPECT_EQ(specs[0].count, 1);
+    EXPECT_EQ(specs[1].count, 0);
+    EXPECT_EQ(cargv_opt(&cargv, "--size"), 1);
+    EXPECT_EQ(cargv_shift(&cargv, 2), 2);
+
+    // Unknown option
+    EXPECT_EQ(cargv_dispatch(&cargv, specs, 2), 0);
+    EXPECT_EQ(cargv_opt(&cargv, "--unknown"), 1);
+
+    // Wildcard, and overflow
+    testing::internal::CaptureStderr();
+    EXPECT_EQ(cargv_dispatch(&cargv, specs, _c(specs)), CARGV_VAL_OVERFLOW);
+    testing::internal::GetCapturedStderr();
+    EXPECT_EQ(specs[2].count, 1);
+    EXPECT_EQ(cargv_len(&cargv), 1);
+}
+
+TEST_F(Test_cargv, dispatch_unknown)
+{
+    static const char *args[] = { _name,
+        "-v", "file1", "-", "-z", "--bogus", "file2",
+    };
+    cargv_int_t num;
+    const char *files[4];
+    struct cargv_spec_t specs[] = {
+        {"-v", CARGV_FLAG, "VERBOSE", NULL, 0, NULL, NULL, 0},
+        {"-n", CARGV_INT, "NUM", &num, 1, NULL, NULL, 0},
+        {NULL, CARGV_TEXT, "FILE", files, _c(files), NULL, NULL, 0},
+    };
+
+    // Unknown options are not taken as positional texts
+    ASSERT_EQ(cargv_init(&cargv, _name, _c(args), args), CARGV_OK);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    EXPECT_EQ(cargv_dispatch(&cargv, specs, _c(specs)), 3);
+    ASSERT_EQ(specs[2].count, 2);
+    EXPECT_STREQ(files[0], "file1");
+    EXPECT_STREQ(files[1], "-");
+    EXPECT_EQ(cargv_opt(&cargv, "-z"), 1);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    EXPECT_EQ(cargv_dispatch(&cargv, specs, _c(specs)), 0);
+    EXPECT_EQ(cargv_opt(&cargv, "--bogus"), 1);
+}
+
+TEST_F(Test_cargv, dispatch_combined)
+{
+    static const char *args[] = { _name, "-vs", };
+    static const char data[] = "-v\n-s\n12\n-vs\n";
+    int fds[2];
+    char win[6];
+    cargv_int_t size;
+    struct cargv_spec_t specs[] = {
+        {"-v", CARGV_FLAG, "VERBOSE", NULL, 0, NULL, NULL, 0},
+        {"-s", CARGV_INT, "SIZE", &size, 1, NULL, NULL, 0},
+    };
+
+    // Missing value of a combined option: None is taken
+    ASSERT_EQ(cargv_init(&cargv, _name, _c(args), args), CARGV_OK);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    EXPECT_EQ(cargv_dispatch(&cargv, specs, _c(specs)), 0);
+    EXPECT_EQ(specs[0].count, 0);
+    EXPECT_EQ(specs[1].count, 0);
+    EXPECT_EQ(cargv_len(&cargv), 1);
+
+    // Value beyond the window of a stream
+    ASSERT_EQ(pipe(fds), 0);
+    ASSERT_EQ(write(fds[1], data, sizeof(data)-1), (ssize_t)sizeof(data)-1);
+    close(fds[1]);
+    ASSERT_EQ(cargv_init_fd(&cargv, _name, fds[0], '\n', win, _c(win)),
+              CARGV_OK);
+    EXPECT_EQ(cargv_dispatch(&cargv, specs, _c(specs)), 3);
+    EXPECT_EQ(specs[0].count, 1);
+    ASSERT_EQ(specs[1].count, 1);
+    EXPECT_EQ(size, 12);
+    EXPECT_EQ(cargv_len(&cargv), 1);
+    EXPECT_EQ(cargv_opt(&cargv, "-vs"), 1);
+    close(fds[0]);
+}
@@ -0,0 +1,90 @@
+#include "gtest/gtest.h"
+
+#if __cplusplus >= 202002L
+
+#include "cargv/cargv.hpp"
+
+
+#define _c(a)    (ptrdiff_t(sizeof(a)/sizeof((a)[0])))
+
+
+class Test_cargv_hpp : public testing::Test {
+protected:
+    static const char *_name;
+
+    struct cargv_t cargv;
+};
+
+const char *Test_cargv_hpp::_name = "cargv-test";
+
+
+TEST_F(Test_cargv_hpp, opt)
+{
+    static const char *args[] = { _name,
+        "-h", "-xvf", "-xvfxh", "--help", "--helpme", "--verbose", "-", "--",
+        "text", "--me", "--he", "-?", "-h?", "--a_b", "--a", "--b", "--h-",
+    };
+
+    ASSERT_EQ(cargv_init(&cargv, _name, _c(args), args), CARGV_OK);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    while (cargv_len(&cargv) > 0) {
+        EXPECT_EQ(cargv::opt<"-hvxf--help--me--verbose">(cargv),
+                  cargv_opt(&cargv, "-hvxf--help--me--verbose"));
+        EXPECT_EQ(cargv::opt<"-*">(cargv), cargv_opt(&cargv, "-*"));
+        EXPECT_EQ(cargv::opt<"-h--help">(&cargv),
+                  cargv_opt(&cargv, "-h--help"));
+        EXPECT_EQ(cargv::opt<"--a-long-one--help">(cargv),
+                  cargv_opt(&cargv, "--a-long-one--help"));
+        EXPECT_EQ(cargv::opt<"-hx">(cargv), cargv_opt(&cargv, "-hx"));
+        EXPECT_EQ(cargv::opt<"-?h--a_b--h-">(cargv),
+                  cargv_opt(&cargv, "-?h--a_b--h-"));
+        EXPECT_EQ(cargv::opt<"--a---b">(cargv), cargv_opt(&cargv, "--a---b"));
+        EXPECT_EQ(cargv::opt<"">(cargv), 0);
+        EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    }
+    EXPECT_EQ(cargv::opt<"-*">(cargv), 0);
+}
+
+TEST_F(Test_cargv_hpp, opt_buffer)
+{
+    static const char buf[] = "--help\n-v\n";
+
+    ASSERT_EQ(cargv_init_buffer(&cargv, _name, buf, _c(buf)-1, '\n'),
+              CARGV_OK);
+    EXPECT_EQ(cargv::opt<"-v--help">(cargv), 1);
+    EXPECT_EQ(cargv::opt<"--helpme">(cargv), 0);
+    EXPECT_EQ(cargv_shift(&cargv, 1), 1);
+    EXPECT_EQ(cargv::opt<"-v--help">(cargv), 1);
+    EXPECT_EQ(cargv::opt<"--v">(cargv), 0);
+}
+
+TEST(Test_cargv_hpp_spec, parse)
+{
+    using cargv::detail::parse;
+
+    EXPECT_TRUE(parse("-h--help", 8).valid);
+    EXPECT_TRUE(parse("--1st-option--2nd-option", 24).valid);
+    EXPECT_TRUE(parse("-*", 2).wildcard);
+    EXPECT_FALSE(parse("h--help", 7).valid);
+    EXPECT_FALSE(parse("h", 1).valid);
+
+    // Split as cargv_opt() does
+    EXPECT_EQ(parse("-h-", 3).shortc, 2u);
+    EXPECT_EQ(parse("-h----help", 10).longc, 1u);
+    EXPECT_EQ(parse("--a---b", 7).longc, 2u);
+    EXPECT_EQ(parse("--a---b", 7).lens[1], 2u);
+    EXPECT_TRUE(parse("--he lp", 7).valid);
+    EXPECT_TRUE(parse("-?--a_b", 7).valid);
+}
+
+#elif defined(GTEST_SKIP)
+
+TEST(Test_cargv_hpp, cpp20)
+{
+    GTEST_SKIP() << "cargv.hpp requires C++20, which this build is not";
+}
+
+#else
+  #warning "cargv.hpp requires C++20, and its tests are skipped"
+
+#endif  // __cplusplus >= 202002L